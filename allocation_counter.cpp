@@ -0,0 +1,144 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : allocation_counter
+ * @created     : Friday October 16, 2026 18:41:52 CEST
+ * @license     : MIT
+ * */
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include <utility>
+#include "allocation_counter.hpp"
+
+
+namespace expr
+{
+
+namespace detail
+{
+    // Zero-initialized before any dynamic initialization: operator new can be
+    // called before main
+    std::atomic<std::size_t> allocations[phases];
+    std::atomic<std::size_t> allocated[phases];
+    thread_local phase current = phase::none;
+} // namespace detail
+
+bool allocation_counter::enabled() noexcept
+{
+#ifdef EXPR_COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+auto allocation_counter::of(phase p) noexcept
+    -> totals
+{
+    auto const i = static_cast<std::size_t>(p);
+    return { detail::allocations[i].load(), detail::allocated[i].load() };
+}
+
+void allocation_counter::reset() noexcept
+{
+    for ( std::size_t i = 0; i < phases; ++i ) {
+        detail::allocations[i].store(0);
+        detail::allocated[i].store(0);
+    }
+}
+
+void allocation_counter::record(std::size_t bytes) noexcept
+{
+    auto const i = static_cast<std::size_t>(detail::current);
+    detail::allocations[i].fetch_add(1, std::memory_order_relaxed);
+    detail::allocated[i].fetch_add(bytes, std::memory_order_relaxed);
+}
+
+phase_scope::phase_scope(phase p) noexcept :
+    _previous{ std::exchange(detail::current, p) }
+{ ; }
+
+phase_scope::~phase_scope()
+{
+    detail::current = _previous;
+}
+
+} // namespace expr
+
+#ifdef EXPR_COUNT_ALLOCATIONS
+
+// The nothrow forms end up here in libstdc++ and libc++. The aligned ones are
+// counted too: the stripes of the statistics are over-aligned
+void * operator new(std::size_t size)
+{
+    expr::allocation_counter::record(size);
+    if ( auto * p = std::malloc(size == 0 ? 1 : size) ) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void * operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void * p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void * p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void * p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void * p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void * operator new(std::size_t size, std::align_val_t align)
+{
+    expr::allocation_counter::record(size);
+    // aligned_alloc takes a multiple of the alignment
+    auto const a = static_cast<std::size_t>(align);
+    auto const bytes = size == 0 ? a : (size + a - 1) / a * a;
+    if ( auto * p = std::aligned_alloc(a, bytes) ) {
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+void * operator new[](std::size_t size, std::align_val_t align)
+{
+    return ::operator new(size, align);
+}
+
+void operator delete(void * p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void * p, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void * p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void * p, std::size_t, std::align_val_t) noexcept
+{
+    std::free(p);
+}
+
+#endif
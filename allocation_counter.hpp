@@ -0,0 +1,60 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : allocation_counter
+ * @created     : Friday October 16, 2026 18:36:15 CEST
+ * @license     : MIT
+ * */
+
+#ifndef ALLOCATION_COUNTER_HPP
+#define ALLOCATION_COUNTER_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace expr
+{
+
+enum class phase : std::uint8_t { none, parse, build, optimize, compile, eval, };
+inline constexpr std::size_t phases = 6;
+
+// Heap allocations made by each phase, on any thread. They are counted only if
+// the library is built with EXPR_COUNT_ALLOCATIONS defined, which replaces the
+// global operator new: meant for tests, e.g. to check that evaluating a
+// compiled program allocates nothing
+struct allocation_counter
+{
+    struct totals
+    {
+        std::size_t count = 0;
+        std::size_t bytes = 0;
+    };
+
+    static bool enabled() noexcept;
+    static totals of(phase p) noexcept;
+    static void reset() noexcept;
+
+    // Called by the replaced operator new
+    static void record(std::size_t bytes) noexcept;
+};
+
+// The phase of the current thread until the end of the scope; phases nest, and
+// the allocations go to the innermost one
+class phase_scope
+{
+    phase _previous;
+public:
+    explicit phase_scope(phase p) noexcept;
+    ~phase_scope();
+    phase_scope(phase_scope const &) = delete;
+    phase_scope & operator=(phase_scope const &) = delete;
+};
+
+} // namespace expr
+
+#ifdef EXPR_COUNT_ALLOCATIONS
+#define EXPR_PHASE(name) ::expr::phase_scope const expr_phase_scope_{::expr::phase::name}
+#else
+#define EXPR_PHASE(name) static_cast<void>(0)
+#endif
+
+#endif /* ALLOCATION_COUNTER_HPP */
@@ -0,0 +1,339 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : approx
+ * @created     : Friday October 16, 2026 11:02:45 CEST
+ * @license     : MIT
+ * */
+
+#ifndef APPROX_HPP
+#define APPROX_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace expr
+{
+
+// How far the builtins may be from libm: exact uses libm itself, faithful is within
+// a couple of ULP (tan within four), single within 1e-7 relative and coarse within
+// 1e-4 relative
+enum class accuracy { exact, faithful, single, coarse };
+
+// Branch-free replacements for the libm functions, meant to be inlined in the
+// batch loops. Each one is valid only where `domain` is true: the callers fall
+// back on libm for the other arguments (huge, non finite, non positive...)
+namespace approx
+{
+    using real = double;
+
+    inline std::uint64_t bits(real x) noexcept
+    {
+        std::uint64_t b;
+        std::memcpy(&b, &x, sizeof b);
+        return b;
+    }
+
+    inline real from_bits(std::uint64_t b) noexcept
+    {
+        real x;
+        std::memcpy(&x, &b, sizeof x);
+        return x;
+    }
+
+    template <std::size_t N>
+    inline real horner(real x, real const (&c)[N]) noexcept
+    {
+        real result = c[N - 1];
+        for ( std::size_t i = N - 1; i-- > 0; ) {
+            result = result * x + c[i];
+        }
+        return result;
+    }
+
+    // Adding and subtracting 1.5*2^52 rounds to the nearest integer; the integer
+    // is also left in the low bits of the intermediate sum
+    real constexpr shifter = 6755399441055744.0;
+
+    namespace trig
+    {
+        real constexpr limit       = 1e5;
+        real constexpr small       = 7.85398163397448278999e-01;
+        real constexpr two_over_pi = 6.36619772367581382433e-01;
+        real constexpr pio2_1      = 1.57079632673412561417e+00;
+        real constexpr pio2_2      = 6.07710050630396597660e-11;
+        real constexpr pio2_3      = 2.02226624871116645580e-21;
+
+        // sin(r) = r + r^3 * P(r^2), cos(r) = 1 - r^2/2 + r^4 * Q(r^2) on [-pi/4, pi/4]
+        real constexpr sin_faithful[] = {
+            -1.66666666666666324348e-01,  8.33333333332248946124e-03, -1.98412698298579493134e-04,
+             2.75573137070700676789e-06, -2.50507602534068634195e-08,  1.58969099521155010221e-10,
+        };
+        real constexpr cos_faithful[] = {
+             4.16666666666666019037e-02, -1.38888888888741095749e-03,  2.48015872894767294178e-05,
+            -2.75573143513906633035e-07,  2.08757232129817482790e-09, -1.13596475577881948265e-11,
+        };
+        real constexpr sin_single[] = { -1. / 6, 1. / 120, -1. / 5040, 1. / 362880 };
+        real constexpr cos_single[] = { 1. / 24, -1. / 720, 1. / 40320 };
+        real constexpr sin_coarse[] = { -1. / 6, 1. / 120 };
+        real constexpr cos_coarse[] = { 1. / 24, -1. / 720 };
+
+        inline bool domain(real x) noexcept { return std::abs(x) <= limit; }
+
+        // x = k*pi/2 + r: return r and k mod 4
+        template <accuracy A>
+        inline real reduce(real x, unsigned & quadrant) noexcept
+        {
+            auto const shifted = x * two_over_pi + shifter;
+            auto const k       = shifted - shifter;
+            quadrant = static_cast<unsigned>(bits(shifted) & 3);
+            // Three parts at every level: near a large multiple of pi/2 the two
+            // parts alone leave too few correct bits even for the coarse bound
+            return ((x - k * pio2_1) - k * pio2_2) - k * pio2_3;
+        }
+
+        template <accuracy A>
+        inline void kernel(real r, real & s, real & c) noexcept
+        {
+            auto const z = r * r;
+            if constexpr ( A == accuracy::faithful ) {
+                s = r + r * z * horner(z, sin_faithful);
+                c = (1 - 0.5 * z) + z * z * horner(z, cos_faithful);
+            }
+            else if constexpr ( A == accuracy::single ) {
+                s = r + r * z * horner(z, sin_single);
+                c = (1 - 0.5 * z) + z * z * horner(z, cos_single);
+            }
+            else {
+                s = r + r * z * horner(z, sin_coarse);
+                c = (1 - 0.5 * z) + z * z * horner(z, cos_coarse);
+            }
+        }
+    } // namespace trig
+
+    template <accuracy A>
+    inline void sincos(real x, real & sin, real & cos) noexcept
+    {
+        unsigned q;
+        real s, c;
+        trig::kernel<A>(trig::reduce<A>(x, q), s, c);
+        sin = (q & 1) ? c : s;
+        cos = (q & 1) ? s : c;
+        sin = (q & 2) ? -sin : sin;
+        cos = ((q + 1) & 2) ? -cos : cos;
+    }
+
+    template <accuracy A>
+    inline real sin(real x) noexcept
+    {
+        real s, c;
+        sincos<A>(x, s, c);
+        return s;
+    }
+
+    template <accuracy A>
+    inline real cos(real x) noexcept
+    {
+        real s, c;
+        sincos<A>(x, s, c);
+        return c;
+    }
+
+    template <accuracy A>
+    inline real tan(real x) noexcept
+    {
+        unsigned q;
+        real s, c;
+        trig::kernel<A>(trig::reduce<A>(x, q), s, c);
+        return (q & 1) ? -c / s : s / c;
+    }
+
+    // The same, for arguments already known to be in [-pi/4, pi/4]: no reduction needed
+    template <accuracy A>
+    inline real sin_small(real x) noexcept
+    {
+        real s, c;
+        trig::kernel<A>(x, s, c);
+        return s;
+    }
+
+    template <accuracy A>
+    inline real cos_small(real x) noexcept
+    {
+        real s, c;
+        trig::kernel<A>(x, s, c);
+        return c;
+    }
+
+    template <accuracy A>
+    inline real tan_small(real x) noexcept
+    {
+        real s, c;
+        trig::kernel<A>(x, s, c);
+        return s / c;
+    }
+
+    namespace exponential
+    {
+        real constexpr limit        = 708;
+        real constexpr inv_ln2      = 1.44269504088896338700e+00;
+        real constexpr ln2_hi       = 6.93147180369123816490e-01;
+        real constexpr ln2_lo       = 1.90821492927058770002e-10;
+
+        // Taylor series of exp on [-ln2/2, ln2/2]
+        real constexpr faithful[] = {
+            1., 1., 1. / 2, 1. / 6, 1. / 24, 1. / 120, 1. / 720, 1. / 5040, 1. / 40320,
+            1. / 362880, 1. / 3628800, 1. / 39916800, 1. / 479001600, 1. / 6227020800,
+        };
+        real constexpr single[] = { 1., 1., 1. / 2, 1. / 6, 1. / 24, 1. / 120, 1. / 720, 1. / 5040 };
+        real constexpr coarse[] = { 1., 1., 1. / 2, 1. / 6, 1. / 24 };
+
+        inline bool domain(real x) noexcept { return std::abs(x) <= limit; }
+    } // namespace exponential
+
+    template <accuracy A>
+    inline real exp(real x) noexcept
+    {
+        using namespace exponential;
+        auto const shifted = x * inv_ln2 + shifter;
+        auto const k       = shifted - shifter;
+        auto const r       = (x - k * ln2_hi) - k * ln2_lo;
+        auto const e       = static_cast<std::int64_t>(bits(shifted) - bits(shifter));
+        auto const scale   = from_bits(static_cast<std::uint64_t>(e + 1023) << 52);
+
+        if constexpr ( A == accuracy::faithful ) { return horner(r, faithful) * scale; }
+        else if constexpr ( A == accuracy::single ) { return horner(r, single) * scale; }
+        else { return horner(r, coarse) * scale; }
+    }
+
+    namespace logarithm
+    {
+        real constexpr sqrt2  = 1.41421356237309514547e+00;
+        real constexpr ln2_hi = 6.93147180369123816490e-01;
+        real constexpr ln2_lo = 1.90821492927058770002e-10;
+        real constexpr lg[]   = {
+            6.666666666666735130e-01, 3.999999999940941908e-01, 2.857142874366239149e-01,
+            2.222219843214978396e-01, 1.818357216161805012e-01, 1.531383769920937332e-01,
+            1.479819860511658591e-01,
+        };
+        // ln(1+f) = 2s * (1 + s^2/3 + s^4/5 + ...) with s = f / (2+f)
+        real constexpr single[] = { 1., 1. / 3, 1. / 5, 1. / 7 };
+        real constexpr coarse[] = { 1., 1. / 3, 1. / 5 };
+
+        // Positive and normal
+        inline bool domain(real x) noexcept { return x >= 2.2250738585072014e-308 && x <= 1.7976931348623157e308; }
+    } // namespace logarithm
+
+    template <accuracy A>
+    inline real ln(real x) noexcept
+    {
+        using namespace logarithm;
+        auto const b   = bits(x);
+        auto       m   = from_bits((b & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL);
+        auto       k   = static_cast<real>(static_cast<std::int64_t>(b >> 52) - 1023);
+        auto const big = m > sqrt2;
+        m = big ? m * 0.5 : m;
+        k = big ? k + 1 : k;
+
+        auto const f = m - 1;
+        auto const s = f / (2 + f);
+        auto const z = s * s;
+        if constexpr ( A == accuracy::faithful ) {
+            auto const w    = z * z;
+            auto const t1   = w * (lg[1] + w * (lg[3] + w * lg[5]));
+            auto const t2   = z * (lg[0] + w * (lg[2] + w * (lg[4] + w * lg[6])));
+            auto const hfsq = 0.5 * f * f;
+            return k * ln2_hi - ((hfsq - (s * (hfsq + t1 + t2) + k * ln2_lo)) - f);
+        }
+        else if constexpr ( A == accuracy::single ) {
+            return k * ln2_hi + (2 * s * horner(z, single) + k * ln2_lo);
+        }
+        else {
+            return k * ln2_hi + (2 * s * horner(z, coarse) + k * ln2_lo);
+        }
+    }
+
+    namespace arctangent
+    {
+        real constexpr tan_pi_8 = 4.14213562373095145475e-01;
+        real constexpr pio4_hi  = 7.85398163397448278999e-01;
+        real constexpr pio4_lo  = 3.06161699786838301793e-17;
+        real constexpr pio2_hi  = 1.57079632679489655800e+00;
+        real constexpr pio2_lo  = 6.12323399573676603587e-17;
+
+        // atan(u) = u - u * (z * P(z^2) + z^2 * Q(z^2)) with z = u^2, |u| < 7/16
+        real constexpr odd[]  = {
+            3.33333333333329318027e-01, 1.42857142725034663711e-01, 9.09088713343650656196e-02,
+            6.66107313738753120669e-02, 4.97687799461593236017e-02, 1.62858201153657823623e-02,
+        };
+        real constexpr even[] = {
+            -1.99999999998764832476e-01, -1.11111104054623557880e-01, -7.69187620504482999495e-02,
+            -5.83357013379057348645e-02, -3.65315727442169155270e-02,
+        };
+        // Taylor series: atan(u) = u * (1 - u^2/3 + u^4/5 - ...)
+        real constexpr single[] = { 1., -1. / 3, 1. / 5, -1. / 7, 1. / 9, -1. / 11, 1. / 13, -1. / 15 };
+        real constexpr coarse[] = { 1., -1. / 3, 1. / 5, -1. / 7, 1. / 9 };
+
+        inline bool domain(real) noexcept { return true; }
+    } // namespace arctangent
+
+    template <accuracy A>
+    inline real atan(real x) noexcept
+    {
+        using namespace arctangent;
+        // atan(x) = hi + lo + sign * atan(u), with |u| <= tan(pi/8)
+        auto const ax   = std::abs(x);
+        auto const inv  = ax > 1;
+        auto const t    = inv ? 1 / ax : ax;
+        auto const big  = t > tan_pi_8;
+        auto const u    = big ? (t - 1) / (t + 1) : t;
+        auto const hi   = inv ? (big ? pio4_hi : pio2_hi) : (big ? pio4_hi : 0.);
+        auto const lo   = inv ? (big ? pio4_lo : pio2_lo) : (big ? pio4_lo : 0.);
+        auto const sign = inv ? -1. : 1.;
+
+        auto const z = u * u;
+        real a;
+        if constexpr ( A == accuracy::faithful ) {
+            auto const w = z * z;
+            a = u - u * (z * horner(w, odd) + w * horner(w, even));
+        }
+        else if constexpr ( A == accuracy::single ) {
+            a = u * horner(z, single);
+        }
+        else {
+            a = u * horner(z, coarse);
+        }
+        auto const result = hi + (lo + sign * a);
+        return std::signbit(x) ? -result : result;
+    }
+
+    namespace square_root
+    {
+        // Zero and the normal numbers: the magic constant of the coarse level is
+        // far off for subnormals, which are left to libm
+        inline bool domain(real x) noexcept
+        {
+            return x == 0 || (x >= 2.2250738585072014e-308 && x <= 1.7976931348623157e308);
+        }
+    } // namespace square_root
+
+    // The hardware square root is already correctly rounded and vectorizable: only
+    // the coarse level trades it for two Newton steps on the reciprocal square root
+    template <accuracy A>
+    inline real sqrt(real x) noexcept
+    {
+        if constexpr ( A == accuracy::coarse ) {
+            auto y = from_bits(0x5fe6eb50c7b537a9ULL - (bits(x) >> 1));
+            y = y * (1.5 - 0.5 * x * y * y);
+            y = y * (1.5 - 0.5 * x * y * y);
+            return x * y;
+        }
+        else {
+            return std::sqrt(x);
+        }
+    }
+} // namespace approx
+
+} // namespace expr
+
+#endif /* APPROX_HPP */
@@ -0,0 +1,140 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : approximation
+ * @created     : Friday October 16, 2026 12:24:37 CEST
+ * @license     : MIT
+ * */
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <algorithm>
+#include "approximation.hpp"
+
+
+namespace expr
+{
+
+namespace detail
+{
+    const_t constexpr pi = 3.141592653589793;
+
+    inline const_t clenshaw(const_t const * c, std::size_t n, const_t t) noexcept
+    {
+        const_t b1 = 0;
+        const_t b2 = 0;
+        for ( auto j = n; j-- > 1; ) {
+            auto const b0 = 2 * t * b1 - b2 + c[j];
+            b2 = b1;
+            b1 = b0;
+        }
+        return t * b1 - b2 + c[0];
+    }
+
+    inline const_t distance(const_t p, const_t f) noexcept
+    {
+        auto const d = std::abs(p - f) / std::max(const_t{1}, std::abs(f));
+        return std::isnan(d) ? std::numeric_limits<const_t>::infinity() : d;
+    }
+
+    // Coefficients of the interpolant in the Chebyshev nodes of [a, b]
+    void interpolate(unary_f const & f, const_t a, const_t b, std::size_t n, const_t * c)
+    {
+        std::vector<const_t> values(n);
+        for ( std::size_t k = 0; k < n; ++k ) {
+            auto const t = std::cos((k + 0.5) * pi / n);
+            values[k] = f(a + (t + 1) * (b - a) / 2);
+        }
+        for ( std::size_t j = 0; j < n; ++j ) {
+            const_t sum = 0;
+            for ( std::size_t k = 0; k < n; ++k ) {
+                sum += values[k] * std::cos(j * (k + 0.5) * pi / n);
+            }
+            c[j] = (j == 0 ? 1. : 2.) * sum / n;
+        }
+    }
+} // namespace detail
+
+approximation approximation::fit(unary_f const & f, const_t lo, const_t hi, const_t tolerance)
+{
+    if ( ! (lo < hi) || ! (tolerance > 0) ) {
+        throw std::invalid_argument{"An approximation needs lo < hi and a positive tolerance"};
+    }
+
+    approximation result;
+    result._lo = lo;
+    result._hi = hi;
+    auto constexpr coarse = 4 * max_degree;
+    auto constexpr dense  = 64 * max_degree;
+
+    // Largest error of the pieces on `samples` + 1 points of each, when only
+    // `degree` coefficients are used; stops above `limit`
+    auto verify = [&](std::size_t pieces, std::size_t degree, std::size_t samples, const_t limit) {
+        auto const width = (hi - lo) / pieces;
+        const_t worst = 0;
+        for ( std::size_t i = 0; i < pieces && worst <= limit; ++i ) {
+            auto const * c = &result._coefficients[i * max_degree];
+            for ( std::size_t k = 0; k <= samples; ++k ) {
+                auto const t = 2. * k / samples - 1;
+                auto const x = lo + width * (i + (t + 1) / 2);
+                worst = std::max(worst, detail::distance(detail::clenshaw(c, degree, t), f(x)));
+            }
+        }
+        return worst;
+    };
+
+    for ( std::size_t pieces = 1; pieces <= max_pieces; pieces *= 2 ) {
+        auto const width = (hi - lo) / pieces;
+        result._coefficients.assign(pieces * max_degree, 0);
+        for ( std::size_t i = 0; i < pieces; ++i ) {
+            auto const a = lo + width * i;
+            detail::interpolate(f, a, a + width, max_degree, &result._coefficients[i * max_degree]);
+        }
+        if ( verify(pieces, max_degree, coarse, tolerance) > tolerance ) {
+            continue;
+        }
+
+        // Drop the tail of the series while the result is still within the tolerance
+        auto degree = max_degree;
+        while ( degree > 1 && verify(pieces, degree - 1, coarse, tolerance) <= tolerance ) {
+            --degree;
+        }
+        // The last check is on a grid 16 times denser: what it misses is narrower
+        // than a sixty-fourth of the width of a piece over the degree
+        auto const error = verify(pieces, degree, dense, std::numeric_limits<const_t>::infinity());
+        if ( error > tolerance ) {
+            continue;
+        }
+
+        std::vector<const_t> coefficients(pieces * degree);
+        for ( std::size_t i = 0; i < pieces; ++i ) {
+            std::copy_n(&result._coefficients[i * max_degree], degree, &coefficients[i * degree]);
+        }
+        result._error        = error;
+        result._coefficients = std::move(coefficients);
+        result._degree       = degree;
+        result._scale        = pieces / (hi - lo);
+        return result;
+    }
+    throw std::domain_error{"The function cannot be approximated within the tolerance"};
+}
+
+const_t approximation::operator()(const_t const & x) const noexcept
+{
+    if ( ! (x >= _lo && x <= _hi) ) {
+        return std::numeric_limits<const_t>::quiet_NaN();
+    }
+    auto const position = (x - _lo) * _scale;
+    auto const piece    = std::min(static_cast<std::size_t>(position), this->pieces() - 1);
+    auto const t        = 2 * (position - piece) - 1;
+    return detail::clenshaw(&_coefficients[piece * _degree], _degree, t);
+}
+
+void approximation::operator()(const_t const * in, const_t * out, std::size_t n) const noexcept
+{
+    for ( std::size_t i = 0; i < n; ++i ) {
+        out[i] = (*this)(in[i]);
+    }
+}
+
+} // namespace expr
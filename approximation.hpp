@@ -0,0 +1,53 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : approximation
+ * @created     : Friday October 16, 2026 12:20:14 CEST
+ * @license     : MIT
+ * */
+
+#ifndef APPROXIMATION_HPP
+#define APPROXIMATION_HPP
+
+#include <vector>
+#include <cstddef>
+#include <functional>
+#include "expression.hpp"
+
+namespace expr
+{
+
+// A function of one variable replaced, over [lo, hi], by Chebyshev polynomials
+// on equally wide pieces: evaluating it costs the same whatever the function was
+class approximation
+{
+    const_t _lo;
+    const_t _hi;
+    const_t _scale;         // pieces per unit
+    std::size_t _degree;    // coefficients per piece
+    const_t _error;         // the largest error on the samples of the verification
+    std::vector<const_t> _coefficients;
+
+    approximation() = default;
+public:
+    static constexpr std::size_t max_degree = 16;
+    static constexpr std::size_t max_pieces = 1 << 14;
+
+    // The error is measured as |p(x) - f(x)| / max(1, |f(x)|) on 1025 points of
+    // each piece, far more than its interpolation nodes: it is an estimate, not a
+    // bound, and a feature of f narrower than the spacing can be missed
+    static approximation fit(unary_f const & f, const_t lo, const_t hi, const_t tolerance);
+
+    const_t operator()(const_t const & x) const noexcept;
+    void operator()(const_t const * in, const_t * out, std::size_t n) const noexcept;
+
+    const_t lower()      const noexcept { return _lo; }
+    const_t upper()      const noexcept { return _hi; }
+    // The largest error found on the samples, at most the tolerance
+    const_t error()      const noexcept { return _error; }
+    std::size_t degree() const noexcept { return _degree; }
+    std::size_t pieces() const noexcept { return _degree == 0 ? 0 : _coefficients.size() / _degree; }
+};
+
+} // namespace expr
+
+#endif /* APPROXIMATION_HPP */
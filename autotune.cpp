@@ -0,0 +1,389 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : autotune
+ * @created     : Friday October 16, 2026 21:52:40 CEST
+ * @license     : MIT
+ * */
+
+#include <cmath>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdio>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include <unistd.h>
+#include "autotune.hpp"
+#include "executor.hpp"
+
+
+namespace expr
+{
+
+namespace detail
+{
+    // Nanoseconds per call of `f(i)`, over rounds of growing size until one lasts 2ms
+    template <typename F>
+    double per_call(F && f)
+    {
+        using clock = std::chrono::steady_clock;
+        std::size_t n = 1;
+        while ( true ) {
+            auto const start = clock::now();
+            for ( std::size_t i = 0; i < n; ++i ) {
+                f(i);
+            }
+            auto const elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+            if ( elapsed >= 2e6 || n >= (std::size_t{1} << 24) ) {
+                return elapsed / static_cast<double>(n);
+            }
+            n *= elapsed < 2e5 ? 10 : 2;
+        }
+    }
+
+    struct sample
+    {
+        double n, u, time;
+    };
+
+    // The least squares coefficients of the terms in `active`, from the normal
+    // equations of all three; the others are 0. False if the system is singular
+    bool solve(double const (&normal)[3][4], bool const (&active)[3], double (&c)[3])
+    {
+        int index[3];
+        int m = 0;
+        for ( int i = 0; i < 3; ++i ) {
+            c[i] = 0;
+            if ( active[i] ) { index[m++] = i; }
+        }
+        double a[3][4] = {};
+        for ( int i = 0; i < m; ++i ) {
+            for ( int j = 0; j < m; ++j ) { a[i][j] = normal[index[i]][index[j]]; }
+            a[i][m] = normal[index[i]][3];
+        }
+        for ( int i = 0; i < m; ++i ) {
+            auto pivot = i;
+            for ( int k = i + 1; k < m; ++k ) {
+                if ( std::abs(a[k][i]) > std::abs(a[pivot][i]) ) { pivot = k; }
+            }
+            std::swap(a[i], a[pivot]);
+            if ( a[i][i] == 0 ) {
+                return false;
+            }
+            for ( int k = 0; k < m; ++k ) {
+                if ( k == i ) { continue; }
+                auto const f = a[k][i] / a[i][i];
+                for ( int j = i; j <= m; ++j ) { a[k][j] -= f * a[i][j]; }
+            }
+        }
+        for ( int i = 0; i < m; ++i ) {
+            c[index[i]] = a[i][m] / a[i][i];
+        }
+        return true;
+    }
+
+    // Least squares of time = fixed + node * n + unit * u with no coefficient
+    // below 0: the most negative term is dropped and the others fitted again
+    // without it, until none is negative (an active set)
+    cost_model::linear fit(std::vector<sample> const & samples)
+    {
+        double normal[3][4] = {};
+        for ( auto const & s : samples ) {
+            double const x[3] = { 1, s.n, s.u };
+            for ( int i = 0; i < 3; ++i ) {
+                for ( int j = 0; j < 3; ++j ) { normal[i][j] += x[i] * x[j]; }
+                normal[i][3] += x[i] * s.time;
+            }
+        }
+        bool active[3] = { true, true, true };
+        double c[3];
+        while ( true ) {
+            if ( ! solve(normal, active, c) ) {
+                return {};
+            }
+            auto const worst = std::min_element(c, c + 3) - c;
+            if ( c[worst] >= 0 ) {
+                return { c[0], c[1], c[2] };
+            }
+            active[worst] = false;
+        }
+    }
+
+    // Formulas far enough apart in size and in cost to tell the terms apart
+    std::vector<std::string> calibration_corpus()
+    {
+        std::vector<std::string> result = {
+            "x+1",
+            "x*x-3*x+2",
+            "sin(x)+cos(x*2)+exp(x/3)+ln(x+2)+atan(x)",
+            "sqrt(x+1)*cbrt(x+2)/(x+3)^3",
+        };
+        std::string sum = "x";
+        for ( int i = 1; i < 24; ++i ) {
+            sum += "+x*" + std::to_string(i) + ".5";
+        }
+        result.push_back(sum);
+        std::string nested = "x";
+        for ( int i = 1; i <= 16; ++i ) {
+            nested = "(" + nested + (i % 2 ? "+" : "*") + std::to_string(i) + ")";
+        }
+        result.push_back(nested);
+        return result;
+    }
+
+    inline double argument(std::size_t i) noexcept
+    {
+        return 0.5 + static_cast<double>(i & 1023) * 1e-3;
+    }
+
+    cost_model::linear read(std::istream & in)
+    {
+        cost_model::linear result;
+        in >> result.fixed >> result.node >> result.unit;
+        return result;
+    }
+
+    std::string write(cost_model::linear const & l)
+    {
+        char text[96];
+        std::snprintf(text, sizeof(text), "%.9g %.9g %.9g", l.fixed, l.node, l.unit);
+        return text;
+    }
+
+    char const magic[] = "expr-cost-model";
+    unsigned constexpr model_format = 1;
+} // namespace detail
+
+char const * engine_name(engine e) noexcept
+{
+    switch (e) {
+        case engine::tree:     return "tree";
+        case engine::program:  return "program";
+        case engine::batch:    return "batch";
+        case engine::parallel: return "parallel";
+        default:               return "invalid";
+    }
+}
+
+cost_model cost_model::calibrate()
+{
+    volatile const_t sink = 0;
+    std::vector<detail::sample> tree, scalar[2], batch[2], compile[2];
+    std::vector<const_t> in(1024), out(1024);
+    for ( std::size_t i = 0; i < in.size(); ++i ) { in[i] = detail::argument(i); }
+
+    for ( auto const & source : detail::calibration_corpus() ) {
+        expression const e{source};
+        auto const n = static_cast<double>(e.size());
+        auto const u = e.cost();
+        tree.push_back({ n, u, detail::per_call([&](std::size_t i) { sink = *e.eval('x', detail::argument(i)); }) });
+        for ( std::size_t l = 0; l < 2; ++l ) {
+            compile_policy p;
+            p.passes = pass_set::level(levels[l]);
+            compile[l].push_back({ n, u, detail::per_call([&](std::size_t) { sink = e.compile('x', p)->code().size(); }) });
+            auto const code = *e.compile('x', p);
+            scalar[l].push_back({ n, u, detail::per_call([&](std::size_t i) { sink = code(detail::argument(i)); }) });
+            auto const block = detail::per_call([&](std::size_t) {
+                code(in.data(), out.data(), in.size());
+                sink = out[0];
+            });
+            batch[l].push_back({ n, u, block / static_cast<double>(in.size()) });
+        }
+    }
+
+    cost_model result;
+    result.tree = detail::fit(tree);
+    for ( std::size_t l = 0; l < 2; ++l ) {
+        result.scalar[l]  = detail::fit(scalar[l]);
+        result.batch[l]   = detail::fit(batch[l]);
+        result.compile[l] = detail::fit(compile[l]);
+    }
+    result.threads = std::max(1u, std::thread::hardware_concurrency());
+    if ( result.threads > 1 ) {
+        executor pool{result.threads};
+        result.dispatch = detail::per_call([&](std::size_t) { pool.run(pool.size(), [](std::size_t) {}); });
+    }
+    return result;
+}
+
+std::optional<cost_model> cost_model::load(std::string const & path)
+{
+    std::ifstream in{path};
+    std::string magic, field;
+    unsigned format = 0, version = 0;
+    cost_model result;
+    if ( ! (in >> magic >> format) || magic != detail::magic || format != detail::model_format ) {
+        return {};
+    }
+    if ( ! (in >> field >> version) || field != "version" || version != compiler_version ) {
+        return {};
+    }
+    if ( ! (in >> field >> result.threads) || field != "threads"
+         || result.threads != std::max(1u, std::thread::hardware_concurrency()) ) {
+        return {};
+    }
+    auto const expect = [&](char const * name) { return static_cast<bool>(in >> field) && field == name; };
+    if ( expect("tree") )     { result.tree       = detail::read(in); } else { return {}; }
+    if ( expect("scalar0") )  { result.scalar[0]  = detail::read(in); } else { return {}; }
+    if ( expect("scalar2") )  { result.scalar[1]  = detail::read(in); } else { return {}; }
+    if ( expect("batch0") )   { result.batch[0]   = detail::read(in); } else { return {}; }
+    if ( expect("batch2") )   { result.batch[1]   = detail::read(in); } else { return {}; }
+    if ( expect("compile0") ) { result.compile[0] = detail::read(in); } else { return {}; }
+    if ( expect("compile2") ) { result.compile[1] = detail::read(in); } else { return {}; }
+    if ( ! expect("dispatch") || ! (in >> result.dispatch) ) {
+        return {};
+    }
+    return result;
+}
+
+// Written aside and renamed, as the disk_cache does: a concurrent reader sees
+// the old file or the new one
+bool cost_model::store(std::string const & path) const
+{
+    static std::atomic<unsigned> counter{0};
+    auto const temporary = path + '.' + std::to_string(::getpid()) + '.' + std::to_string(counter++);
+    {
+        std::ofstream out{temporary, std::ios::trunc};
+        out << detail::magic << ' ' << detail::model_format << '\n'
+            << "version " << compiler_version << '\n'
+            << "threads " << threads << '\n'
+            << "tree "     << detail::write(tree)       << '\n'
+            << "scalar0 "  << detail::write(scalar[0])  << '\n'
+            << "scalar2 "  << detail::write(scalar[1])  << '\n'
+            << "batch0 "   << detail::write(batch[0])   << '\n'
+            << "batch2 "   << detail::write(batch[1])   << '\n'
+            << "compile0 " << detail::write(compile[0]) << '\n'
+            << "compile2 " << detail::write(compile[1]) << '\n'
+            << "dispatch " << dispatch << '\n';
+        if ( ! out.flush() ) {
+            out.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if ( std::rename(temporary.c_str(), path.c_str()) != 0 ) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+std::string cost_model::default_path()
+{
+    if ( auto const * path = std::getenv("EXPR_COST_MODEL"); path && *path ) {
+        return path;
+    }
+    if ( auto const * cache = std::getenv("XDG_CACHE_HOME"); cache && *cache ) {
+        return std::string{cache} + "/expr/cost_model";
+    }
+    if ( auto const * home = std::getenv("HOME"); home && *home ) {
+        return std::string{home} + "/.cache/expr/cost_model";
+    }
+    return {};
+}
+
+// Storing is best effort: without a writable cache, the next process calibrates again
+cost_model const & cost_model::local()
+{
+    static cost_model const model = [] {
+        auto const path = default_path();
+        if ( path.empty() ) {
+            return calibrate();
+        }
+        if ( auto stored = load(path) ) {
+            return *stored;
+        }
+        auto const result = calibrate();
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path{path}.parent_path(), error);
+        result.store(path);
+        return result;
+    }();
+    return model;
+}
+
+plan choose(expression const & e, workload const & w, cost_model const & m, bool parallel)
+{
+    auto const n = static_cast<double>(e.size());
+    auto const u = e.cost();
+    auto const calls  = static_cast<double>(w.calls);
+    auto const points = static_cast<double>(w.points);
+
+    plan best{ engine::tree, 0, 0, calls * points * m.tree(n, u) };
+    auto const consider = [&](engine which, unsigned level, double compile, double eval) {
+        if ( compile + eval < best.compile_ns + best.eval_ns ) {
+            best = { which, level, compile, eval };
+        }
+    };
+    for ( std::size_t l = 0; l < 2; ++l ) {
+        auto const level   = cost_model::levels[l];
+        auto const compile = m.compile[l](n, u);
+        consider(engine::program, level, compile, calls * points * m.scalar[l](n, u));
+        if ( w.points > 1 ) {
+            // The fixed part of the batch line is per value: per call there is the one of a scalar call
+            auto const values = m.batch[l](n, u);
+            consider(engine::batch, level, compile, calls * (m.scalar[l].fixed + points * values));
+            if ( parallel && m.threads > 1 ) {
+                auto const share = std::ceil(points / m.threads);
+                consider(engine::parallel, level, compile, calls * (m.dispatch + share * values));
+            }
+        }
+    }
+    return best;
+}
+
+tuned_expression::tuned_expression(expression source, char x, workload const & w, executor * pool) :
+    tuned_expression{ std::move(source), x, w, pool, cost_model::local() }
+{ ; }
+
+tuned_expression::tuned_expression(expression source, char x, workload const & w, executor * pool, cost_model const & m) :
+    _source{ std::move(source) }, _variable{x}, _pool{pool}
+{
+    _source.validate(x);
+    _plan = choose(_source, w, m, pool != nullptr && pool->size() > 1);
+    if ( _plan.which != engine::tree ) {
+        compile_policy p;
+        p.passes = pass_set::level(_plan.level);
+        _code = _source.compile(x, p);
+    }
+}
+
+const_t tuned_expression::operator()(const_t const & x) const
+{
+    if ( ! _code ) {
+        return *_source.eval(_variable, x);
+    }
+    return (*_code)(x);
+}
+
+void tuned_expression::operator()(span<const_t const> in, span<const_t> out) const
+{
+    auto const n = std::min(in.size(), out.size());
+    switch (_plan.which) {
+        case engine::tree:
+            for ( std::size_t i = 0; i < n; ++i ) { out[i] = *_source.eval(_variable, in[i]); }
+            break;
+        case engine::program:
+            for ( std::size_t i = 0; i < n; ++i ) { out[i] = (*_code)(in[i]); }
+            break;
+        case engine::batch:
+            (*_code)(in.data(), out.data(), n);
+            break;
+        case engine::parallel: {
+            // One part per thread, as the model assumes
+            auto const parts = std::max<std::size_t>(1, std::min(_pool->size(), n / program::lanes));
+            auto const chunk = (n + parts - 1) / parts;
+            _pool->run(parts, [&](std::size_t i) {
+                auto const first = std::min(n, i * chunk);
+                auto const count = std::min(chunk, n - first);
+                (*_code)(in.data() + first, out.data() + first, count);
+            });
+            break;
+        }
+    }
+}
+
+} // namespace expr
@@ -0,0 +1,112 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : autotune
+ * @created     : Friday October 16, 2026 21:37:12 CEST
+ * @license     : MIT
+ * */
+
+#ifndef AUTOTUNE_HPP
+#define AUTOTUNE_HPP
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include "expression.hpp"
+#include "program.hpp"
+
+namespace expr
+{
+
+class executor;
+
+// The ways an expression can be evaluated: walking the tree, running the
+// program one value at a time, running it on blocks of values, or on blocks
+// spread over the threads of an executor
+enum class engine : std::uint8_t { tree, program, batch, parallel, };
+
+char const * engine_name(engine e) noexcept;
+
+// How an expression is going to be used: `calls` calls, on `points` values each
+struct workload
+{
+    std::size_t calls  = 1;
+    std::size_t points = 1;
+};
+
+// The speed of this machine. Every time is modelled as fixed + node * n + unit * u
+// nanoseconds, for an expression of n nodes and a cost of u (expression::size()
+// and expression::cost()); the coefficients are fitted on a few formulas by
+// calibrate(), which takes a fraction of a second
+struct cost_model
+{
+    struct linear
+    {
+        double fixed = 0;
+        double node  = 0;
+        double unit  = 0;
+
+        double operator()(double n, double u) const noexcept { return fixed + node * n + unit * u; }
+    };
+
+    static constexpr unsigned levels[] = { 0, 2 };     // the ones of the passes which are modelled
+
+    linear tree;            // per value
+    linear scalar[2];       // per value, a program compiled at each level
+    linear batch[2];        // per value, in blocks
+    linear compile[2];      // per compilation
+    double dispatch = 0;    // a run of an executor over its threads
+    unsigned threads = 1;   // of the machine
+
+    static cost_model calibrate();
+
+    // A text file, tied to the compiler version and to the number of threads:
+    // a file from another version, or another machine, is not loaded
+    static std::optional<cost_model> load(std::string const & path);
+    bool store(std::string const & path) const;
+
+    // $EXPR_COST_MODEL, or expr/cost_model in $XDG_CACHE_HOME or ~/.cache;
+    // empty if there is none of them
+    static std::string default_path();
+
+    // The one of default_path(), calibrated and stored there the first time
+    static cost_model const & local();
+};
+
+// The fastest way for a workload, compilation included
+struct plan
+{
+    engine which = engine::tree;
+    unsigned level = 0;         // of the passes, if compiled
+    double compile_ns = 0;      // estimated
+    double eval_ns = 0;         // estimated, for the whole workload
+};
+
+// `parallel` says whether an executor would be there to use
+plan choose(expression const & e, workload const & w, cost_model const & m, bool parallel = false);
+
+// An expression of one variable, evaluated the way choose() picked for the
+// workload it was made for. Any call shape works with any plan: a scalar call
+// on a batch plan runs the program on one value, and so on
+class tuned_expression
+{
+    expression _source;
+    std::optional<program> _code;
+    char _variable;
+    plan _plan;
+    executor * _pool;
+
+public:
+    // Throws std::logic_error as validate(x) does
+    tuned_expression(expression source, char x, workload const & w, executor * pool = nullptr);
+    tuned_expression(expression source, char x, workload const & w, executor * pool, cost_model const & m);
+
+    const_t operator()(const_t const & x) const;
+    void operator()(span<const_t const> in, span<const_t> out) const;
+
+    plan const & chosen() const noexcept { return _plan; }
+};
+
+} // namespace expr
+
+#endif /* AUTOTUNE_HPP */
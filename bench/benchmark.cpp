@@ -0,0 +1,369 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : benchmark
+ * @created     : Friday October 16, 2026 19:24:08 CEST
+ * @license     : MIT
+ * */
+
+// Times every phase of the pipeline, and every way of evaluating, over a corpus
+// of expressions; the results are written as JSON so two runs can be compared.
+//   cmake -S . -B build && cmake --build build --target benchmark
+//   ./build/benchmark [--min-time=0.2] [--filter=text] [--out=file.json]
+// With --scaling the corpus is made of random expressions of 8, 16... up to
+// --max-size operands (from --seed), to see how each phase grows with the size.
+// With --counters (Linux) cycles, instructions, branch and cache misses per
+// operation are reported as well
+
+#include <ctime>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include "expression.hpp"
+#include "program.hpp"
+#include "generator.hpp"
+#include "perf_counters.hpp"
+
+namespace expr
+{
+
+// The private phases of an expression
+struct benchmark_access
+{
+    static std::string preparse(expression const & e, std::string && src)
+    {
+        return e.preparse(std::move(src));
+    }
+    static std::vector<variant_t> parse_impl(expression & e, std::string_view src)
+    {
+        return e.parse_impl(src);
+    }
+    static expression & build_impl(expression & e, std::string && src)
+    {
+        return e.build_impl(std::move(src));
+    }
+};
+
+} // namespace expr
+
+namespace bench
+{
+
+using clock = std::chrono::steady_clock;
+
+// Keeps the compiler from dropping a result which is never used
+template <typename T>
+inline void keep(T const & value)
+{
+#if defined(__GNUC__)
+    asm volatile("" : : "g"(&value) : "memory");
+#else
+    static void const * volatile sink;
+    sink = &value;
+#endif
+}
+
+struct sample
+{
+    std::string source;
+    std::string corpus;
+    std::size_t operands = 0;   // of the random ones
+};
+
+struct result
+{
+    std::string phase;
+    std::string corpus;
+    std::size_t length;
+    std::size_t operands;
+    std::uint64_t iterations;
+    double ns_per_op;
+    perf_counters::values counters; // per operation, if asked and available
+};
+
+struct options
+{
+    double min_time = 0.2;
+    std::string filter;
+    std::string out;
+    bool scaling = false;
+    std::uint64_t seed = 1;
+    std::size_t max_size = 1024;
+    perf_counters * counters = nullptr;
+};
+
+// Rounds of growing size until one lasts `min_time`; `prepare(n)` runs before
+// each round, out of the timing, for the phases which consume their input
+template <typename Prepare, typename Op>
+result measure(options const & opt, Prepare && prepare, Op && op)
+{
+    std::uint64_t n = 1;
+    while ( true ) {
+        prepare(n);
+        if ( opt.counters ) { opt.counters->start(); }
+        auto const start = clock::now();
+        for ( std::uint64_t i = 0; i < n; ++i ) {
+            op(i);
+        }
+        auto const elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        auto counters = opt.counters ? opt.counters->stop() : perf_counters::values{};
+        if ( elapsed >= opt.min_time || n >= (std::uint64_t{1} << 40) ) {
+            for ( auto & c : counters ) {
+                if ( c ) { *c /= static_cast<double>(n); }
+            }
+            return { {}, {}, 0, 0, n, elapsed * 1e9 / static_cast<double>(n), counters };
+        }
+        auto const wanted = elapsed > 0 ? opt.min_time * 1.4 / elapsed * static_cast<double>(n) : 100.0 * n;
+        n = std::max(n * 2, std::min(n * 100, static_cast<std::uint64_t>(wanted)));
+    }
+}
+
+template <typename Op>
+result measure(options const & opt, Op && op)
+{
+    return measure(opt, [](std::uint64_t) {}, std::forward<Op>(op));
+}
+
+// The argument of the i-th call: always different, always in the domain of every corpus
+inline double argument(std::uint64_t i)
+{
+    return 0.5 + static_cast<double>(i & 1023) * 1e-3;
+}
+
+std::vector<sample> corpus()
+{
+    std::vector<sample> result = {
+        { "x+1",                                                          "short" },
+        { "3*x^2-2*x+1",                                                  "short" },
+        { "sin(x)/x",                                                     "short" },
+        { "sin(x)*cos(x)+exp(-x/3)*ln(x+2)+atan(x)*sqrt(x+1)+tan(x/7)",   "transcendental" },
+        { "exp(sin(x))*cbrt(x+2)-asin(x/9)*acos(x/9)+abs(ln(x))",        "transcendental" },
+    };
+
+    std::string nested = "x";
+    for ( int i = 1; i <= 32; ++i ) {
+        nested = "(" + nested + (i % 2 ? "+" : "*") + std::to_string(i) + ")";
+    }
+    result.push_back({ nested, "deep" });
+
+    std::string calls = "x";
+    for ( int i = 0; i < 16; ++i ) {
+        calls = (i % 2 ? "cos(" : "sin(") + calls + ")";
+    }
+    result.push_back({ calls, "deep" });
+
+    std::string sum = "x";
+    for ( int i = 1; i < 200; ++i ) {
+        sum += "+" + std::to_string(i) + "*x";
+    }
+    result.push_back({ sum, "long" });
+    return result;
+}
+
+// Random expressions of growing size; the other knobs keep their defaults
+std::vector<sample> scaling(options const & opt)
+{
+    std::vector<sample> result;
+    for ( std::size_t size = 8; size <= opt.max_size; size *= 2 ) {
+        generator_options g;
+        g.size = size;
+        generator next{opt.seed + size, g};
+        result.push_back({ next(), "random", size });
+    }
+    return result;
+}
+
+using phase_f = std::function<result(sample const &, options const &)>;
+
+std::vector<std::pair<std::string, phase_f>> phases()
+{
+    using expr::expression;
+    using expr::benchmark_access;
+
+    return {
+        { "preparse", [](sample const & s, options const & opt) {
+            expression const e{"0"};
+            return measure(opt, [&](std::uint64_t) {
+                keep(benchmark_access::preparse(e, std::string{s.source}));
+            });
+        } },
+        { "parse_impl", [](sample const & s, options const & opt) {
+            expression e{"0"};
+            auto const preparsed = benchmark_access::preparse(e, std::string{s.source});
+            return measure(opt, [&](std::uint64_t) {
+                keep(benchmark_access::parse_impl(e, preparsed));
+            });
+        } },
+        { "build_impl", [](sample const & s, options const & opt) {
+            expression e{"0"};
+            return measure(opt, [&](std::uint64_t) {
+                keep(benchmark_access::build_impl(e, std::string{s.source}));
+            });
+        } },
+        { "optimize", [](sample const & s, options const & opt) {
+            // optimize() rewrites the tree, which copies share: each call needs its own
+            std::vector<expression> fresh;
+            return measure(opt,
+                [&](std::uint64_t n) {
+                    fresh.clear();
+                    for ( std::uint64_t i = 0; i < n; ++i ) {
+                        fresh.emplace_back(s.source);
+                    }
+                },
+                [&](std::uint64_t i) { keep(fresh[i].optimize()); }
+            );
+        } },
+        { "eval", [](sample const & s, options const & opt) {
+            expression e{s.source};
+            return measure(opt, [&](std::uint64_t i) {
+                e.set_param('x', argument(i));
+                keep(e.eval());
+            });
+        } },
+        { "eval_x", [](sample const & s, options const & opt) {
+            expression const e{s.source};
+            return measure(opt, [&](std::uint64_t i) { keep(e.eval('x', argument(i))); });
+        } },
+        { "as_unary", [](sample const & s, options const & opt) {
+            auto const f = *expression{s.source}.as_unary('x');
+            return measure(opt, [&](std::uint64_t i) { keep(f(argument(i))); });
+        } },
+        { "compile", [](sample const & s, options const & opt) {
+            expression const e{s.source};
+            return measure(opt, [&](std::uint64_t) { keep(e.compile('x')); });
+        } },
+        { "program", [](sample const & s, options const & opt) {
+            auto const p = *expression{s.source}.compile('x');
+            return measure(opt, [&](std::uint64_t i) { keep(p(argument(i))); });
+        } },
+        { "program_batch", [](sample const & s, options const & opt) {
+            // Per value, over blocks of 1024
+            auto const p = *expression{s.source}.compile('x');
+            std::vector<double> in(1024), out(1024);
+            for ( std::size_t i = 0; i < in.size(); ++i ) { in[i] = argument(i); }
+            auto r = measure(opt, [&](std::uint64_t) {
+                p(in.data(), out.data(), in.size());
+                keep(out);
+            });
+            r.ns_per_op /= static_cast<double>(in.size());
+            for ( auto & c : r.counters ) {
+                if ( c ) { *c /= static_cast<double>(in.size()); }
+            }
+            return r;
+        } },
+    };
+}
+
+std::string escape(std::string const & text)
+{
+    std::string result;
+    for ( auto c : text ) {
+        if ( c == '"' || c == '\\' ) { result += '\\'; }
+        result += c;
+    }
+    return result;
+}
+
+// The counters present, and the IPC if both its terms are
+std::string counters(perf_counters::values const & values)
+{
+    std::ostringstream out;
+    for ( std::size_t i = 0; i < events; ++i ) {
+        if ( values[i] ) {
+            out << ", \"" << event_names[i] << "\": " << *values[i];
+        }
+    }
+    auto const & cycles       = values[static_cast<std::size_t>(event::cycles)];
+    auto const & instructions = values[static_cast<std::size_t>(event::instructions)];
+    if ( cycles && instructions && *cycles > 0 ) {
+        out << ", \"ipc\": " << *instructions / *cycles;
+    }
+    return out.str();
+}
+
+void write(std::ostream & out, options const & opt, std::vector<result> const & results)
+{
+    char date[32];
+    auto const now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    out << "{\n  \"context\": {\n";
+    out << "    \"date\": \"" << date << "\",\n";
+#if defined(__VERSION__)
+    out << "    \"compiler\": \"" << escape(__VERSION__) << "\",\n";
+#endif
+    out << "    \"min_time\": " << opt.min_time << ",\n";
+    out << "    \"seed\": " << opt.seed << "\n  },\n";
+    out << "  \"benchmarks\": [\n";
+    for ( std::size_t i = 0; i < results.size(); ++i ) {
+        auto const & r = results[i];
+        out << "    { \"name\": \"" << r.phase << '/' << r.corpus << '/' << r.length << "\", "
+            << "\"phase\": \"" << r.phase << "\", \"corpus\": \"" << r.corpus << "\", "
+            << "\"length\": " << r.length << ", \"operands\": " << r.operands << ", \"iterations\": " << r.iterations << ", "
+            << "\"ns_per_op\": " << r.ns_per_op << counters(r.counters) << " }" << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    out << "  ]\n}\n";
+}
+
+options parse(int argc, char ** argv)
+{
+    options opt;
+    for ( int i = 1; i < argc; ++i ) {
+        std::string const arg = argv[i];
+        auto const value = arg.substr(arg.find('=') + 1);
+        if      ( arg.rfind("--min-time=", 0) == 0 ) { opt.min_time = std::stod(value); }
+        else if ( arg.rfind("--filter=",   0) == 0 ) { opt.filter   = value; }
+        else if ( arg.rfind("--out=",      0) == 0 ) { opt.out      = value; }
+        else if ( arg.rfind("--seed=",     0) == 0 ) { opt.seed     = std::stoull(value); }
+        else if ( arg.rfind("--max-size=", 0) == 0 ) { opt.max_size = std::stoull(value); }
+        else if ( arg == "--scaling" )                { opt.scaling  = true; }
+        else if ( arg == "--counters" ) {
+            static perf_counters counters;
+            if ( ! counters.available() ) {
+                std::cerr << "No hardware counters (" << counters.error() << "), timing only\n";
+            }
+            opt.counters = &counters;
+        }
+        else {
+            throw std::invalid_argument{"Unknown option " + arg};
+        }
+    }
+    return opt;
+}
+
+} // namespace bench
+
+int main(int argc, char ** argv)
+{
+    auto const opt = bench::parse(argc, argv);
+
+    auto const corpus = opt.scaling ? bench::scaling(opt) : bench::corpus();
+    std::vector<bench::result> results;
+    for ( auto const & [name, run] : bench::phases() ) {
+        for ( auto const & s : corpus ) {
+            if ( (name + '/' + s.corpus).find(opt.filter) == std::string::npos ) {
+                continue;
+            }
+            auto r = run(s, opt);
+            r.phase  = name;
+            r.corpus = s.corpus;
+            r.length = s.source.size();
+            r.operands = s.operands;
+            std::cerr << name << '/' << s.corpus << '/' << r.length << ": " << r.ns_per_op << " ns\n";
+            results.push_back(std::move(r));
+        }
+    }
+
+    if ( opt.out.empty() ) {
+        bench::write(std::cout, opt, results);
+    }
+    else {
+        std::ofstream out{opt.out};
+        bench::write(out, opt, results);
+    }
+}
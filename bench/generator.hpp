@@ -0,0 +1,116 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : generator
+ * @created     : Friday October 16, 2026 19:52:40 CEST
+ * @license     : MIT
+ * */
+
+#ifndef BENCH_GENERATOR_HPP
+#define BENCH_GENERATOR_HPP
+
+#include <array>
+#include <iterator>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace bench
+{
+
+struct generator_options
+{
+    std::size_t size  = 32;     // operands (numbers, variables and parameters)
+    std::size_t depth = 8;      // parentheses and functions nested at most
+    // Relative weights of + - * / ^ %; a power or a modulus always has a small
+    // integer on the right, so that values stay finite and no modulus is by 0
+    std::array<double, 6> operators = { 4, 3, 4, 2, 0.5, 0 };
+    std::size_t parameters = 0; // letters other than x, at most 20
+    double functions = 0.15;    // chance for an operand or a subexpression to be a function argument
+    double constants = 0.4;     // chance for an operand to be a number
+    double grouping  = 0.3;     // chance for a subexpression to be in parentheses
+};
+
+// Valid expressions for the parser, always the same ones for the same seed
+class generator
+{
+    std::mt19937_64 _random;
+    generator_options _options;
+
+public:
+    explicit generator(std::uint64_t seed, generator_options const & options = {}) :
+        _random{seed}, _options{options}
+    { ; }
+
+    std::string operator()()
+    {
+        return this->expression(std::max<std::size_t>(_options.size, 1), _options.depth);
+    }
+
+    generator_options const & options() const noexcept { return _options; }
+
+private:
+    bool chance(double p)
+    {
+        return std::bernoulli_distribution{std::clamp(p, 0.0, 1.0)}(_random);
+    }
+
+    std::size_t uniform(std::size_t lo, std::size_t hi)
+    {
+        return std::uniform_int_distribution<std::size_t>{lo, hi}(_random);
+    }
+
+    std::string function(std::string const & argument)
+    {
+        static constexpr char const * names[] = {
+            "sin", "cos", "tan", "asin", "acos", "atan", "exp", "ln", "abs", "sqrt", "cbrt",
+        };
+        return std::string{names[this->uniform(0, std::size(names) - 1)]} + "(" + argument + ")";
+    }
+
+    // 'e' is left out: after a number it would read as an exponent
+    std::string operand()
+    {
+        static constexpr char letters[] = "abcdfghijklmnopqrsuvw";
+        auto const parameters = std::min(_options.parameters, sizeof(letters) - 1);
+        if ( this->chance(_options.constants) ) {
+            auto const whole = this->uniform(1, 99);
+            return this->chance(0.5) ? std::to_string(whole) : std::to_string(whole) + "." + std::to_string(this->uniform(1, 9));
+        }
+        if ( parameters > 0 && this->chance(0.5) ) {
+            return std::string(1, letters[this->uniform(0, parameters - 1)]);
+        }
+        return "x";
+    }
+
+    std::string expression(std::size_t size, std::size_t depth)
+    {
+        if ( depth > 0 && this->chance(_options.functions) ) {
+            return this->function(this->expression(size, depth - 1));
+        }
+        if ( depth > 0 && size > 1 && this->chance(_options.grouping) ) {
+            return "(" + this->expression(size, depth - 1) + ")";
+        }
+        if ( size == 1 ) {
+            return this->operand();
+        }
+
+        auto const op = std::discrete_distribution<std::size_t>{
+            _options.operators.begin(), _options.operators.end()
+        }(_random);
+        // In parentheses, or the parser could take what follows as part of the exponent or divisor
+        if ( op >= 4 ) {
+            return "(" + this->expression(size - 1, depth) + "^%"[op - 4] + std::to_string(this->uniform(2, 3)) + ")";
+        }
+        // Halves when the depth left could not hold a lopsided split
+        auto const left = (std::size_t{1} << std::min<std::size_t>(depth, 62)) >= size
+            ? this->uniform(1, size - 1)
+            : size / 2;
+        return this->expression(left, depth) + "+-*/"[op] + this->expression(size - left, depth);
+    }
+};
+
+} // namespace bench
+
+#endif /* BENCH_GENERATOR_HPP */
@@ -0,0 +1,139 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : perf_counters
+ * @created     : Friday October 16, 2026 20:18:33 CEST
+ * @license     : MIT
+ * */
+
+#ifndef BENCH_PERF_COUNTERS_HPP
+#define BENCH_PERF_COUNTERS_HPP
+
+#include <array>
+#include <string>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+namespace bench
+{
+
+enum class event : std::size_t { cycles, instructions, branch_misses, l1d_misses, llc_misses, };
+inline constexpr std::size_t events = 5;
+inline constexpr char const * event_names[events] = {
+    "cycles", "instructions", "branch_misses", "l1d_misses", "llc_misses",
+};
+
+// Hardware counters of the calling thread, in user space, through perf_event_open.
+// Each event is opened on its own, so a machine (or a VM) without one of them
+// still gets the others; when the kernel multiplexes them the values are scaled
+// to the whole time they were enabled
+class perf_counters
+{
+    std::array<int, events> _fds;
+    std::string _error;
+
+public:
+    using values = std::array<std::optional<double>, events>;
+
+    perf_counters()
+    {
+        _fds.fill(-1);
+#if defined(__linux__)
+        auto const cache = [](std::uint64_t level) {
+            return level | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        };
+        std::pair<std::uint32_t, std::uint64_t> const configs[events] = {
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+            { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+            { PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_L1D) },
+            { PERF_TYPE_HW_CACHE, cache(PERF_COUNT_HW_CACHE_LL) },
+        };
+        for ( std::size_t i = 0; i < events; ++i ) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size           = sizeof(attr);
+            attr.type           = configs[i].first;
+            attr.config         = configs[i].second;
+            attr.disabled       = 1;
+            attr.exclude_kernel = 1;    // allowed with perf_event_paranoid up to 2
+            attr.exclude_hv     = 1;
+            attr.read_format    = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            _fds[i] = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if ( _fds[i] < 0 && _error.empty() ) {
+                _error = std::string{event_names[i]} + ": " + std::strerror(errno);
+            }
+        }
+#else
+        _error = "hardware counters are read only on Linux";
+#endif
+    }
+
+    ~perf_counters()
+    {
+#if defined(__linux__)
+        for ( auto fd : _fds ) {
+            if ( fd >= 0 ) { ::close(fd); }
+        }
+#endif
+    }
+
+    perf_counters(perf_counters const &) = delete;
+    perf_counters & operator=(perf_counters const &) = delete;
+
+    // At least one event could be opened
+    bool available() const noexcept
+    {
+        for ( auto fd : _fds ) {
+            if ( fd >= 0 ) { return true; }
+        }
+        return false;
+    }
+
+    // Why the first missing event is missing, empty if none is
+    std::string const & error() const noexcept { return _error; }
+
+    void start() noexcept
+    {
+#if defined(__linux__)
+        for ( auto fd : _fds ) {
+            if ( fd >= 0 ) {
+                ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+#endif
+    }
+
+    // The counts since start(); an event never scheduled on the PMU has no value
+    values stop() noexcept
+    {
+        values result;
+#if defined(__linux__)
+        for ( auto fd : _fds ) {
+            if ( fd >= 0 ) { ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0); }
+        }
+        for ( std::size_t i = 0; i < events; ++i ) {
+            std::uint64_t data[3];  // value, time enabled, time running
+            if ( _fds[i] < 0 || ::read(_fds[i], data, sizeof(data)) != sizeof(data) || data[2] == 0 ) {
+                continue;
+            }
+            result[i] = static_cast<double>(data[0]) * static_cast<double>(data[1]) / static_cast<double>(data[2]);
+        }
+#endif
+        return result;
+    }
+};
+
+} // namespace bench
+
+#endif /* BENCH_PERF_COUNTERS_HPP */
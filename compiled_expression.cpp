@@ -0,0 +1,154 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : compiled_expression
+ * @created     : Friday October 16, 2026 15:06:44 CEST
+ * @license     : MIT
+ * */
+
+#include <vector>
+#include <exception>
+#include <stdexcept>
+#include <algorithm>
+#include "compiled_expression.hpp"
+#include "executor.hpp"
+
+
+namespace expr
+{
+
+compiled_expression::compiled_expression(program p) :
+    _program{ std::make_shared<program const>(std::move(p)) }
+{ ; }
+
+compiled_expression::compiled_expression(std::shared_ptr<program const> p) noexcept :
+    _program{ std::move(p) }
+{ ; }
+
+const_t compiled_expression::operator()(const_t const & x) const noexcept
+{
+    stats_scope const scope{_stats.get(), 1, false};
+    return (*_program)(x);
+}
+
+const_t compiled_expression::operator()(const_t const & x, status & s) const noexcept
+{
+    stats_scope const scope{_stats.get(), 1, false};
+    return (*_program)(x, s);
+}
+
+void compiled_expression::operator()(span<const_t const> in, span<const_t> out) const noexcept
+{
+    auto const n = std::min(in.size(), out.size());
+    stats_scope const scope{_stats.get(), n, true};
+    (*_program)(in.data(), out.data(), n);
+}
+
+const_t compiled_expression::operator()(const_t const & x, span<const_t const> params) const noexcept
+{
+    stats_scope const scope{_stats.get(), 1, false};
+    return (*_program)(x, params.data(), params.size());
+}
+
+void compiled_expression::operator()(
+    span<const_t const> in, span<const_t> out, span<const_t const> params
+) const noexcept
+{
+    auto const n = std::min(in.size(), out.size());
+    stats_scope const scope{_stats.get(), n, true};
+    (*_program)(in.data(), out.data(), n, params.data(), params.size());
+}
+
+void compiled_expression::operator()(
+    span<const_t const> in, span<const_t> out, span<const_t const> params, workspace & w
+) const noexcept
+{
+    auto const n = std::min(in.size(), out.size());
+    stats_scope const scope{_stats.get(), n, true};
+    (*_program)(in.data(), out.data(), n, params.data(), params.size(), w);
+}
+
+void compiled_expression::grid(
+    span<const_t const> xs, std::size_t slot, span<const_t const> ys, span<const_t> out
+) const
+{
+    this->grid(xs, slot, ys, out, {});
+}
+
+// A row is a call of the batch kernel, which computes the instructions not
+// depending on the variable once per call
+void compiled_expression::grid(
+    span<const_t const> xs, std::size_t slot, span<const_t const> ys, span<const_t> out,
+    span<const_t const> params
+) const
+{
+    auto const & bound = _program->bindings();
+    if ( slot >= bound.size() ) {
+        throw std::invalid_argument{"The axis of the rows is not a parameter"};
+    }
+    if ( out.size() != xs.size() * ys.size() ) {
+        throw std::invalid_argument{"Output of a size different from the grid"};
+    }
+    std::vector<const_t> values(bound.begin(), bound.end());
+    std::copy_n(params.data(), std::min(params.size(), values.size()), values.begin());
+
+    stats_scope const scope{_stats.get(), out.size(), true};
+    for ( std::size_t j = 0; j < ys.size(); ++j ) {
+        values[slot] = ys[j];
+        (*_program)(xs.data(), out.data() + j * xs.size(), xs.size(), values.data(), values.size());
+    }
+}
+
+compiled_expression compiled_expression::instrument(std::string name, stats_registry & registry) const
+{
+    auto result = *this;
+    result._stats = registry.add(std::move(name));
+    return result;
+}
+
+std::size_t compiled_expression::slot(char name) const noexcept
+{
+    auto const & names = _program->parameters();
+    auto const it = std::find(names.begin(), names.end(), name);
+    return it == names.end() ? npos : static_cast<std::size_t>(it - names.begin());
+}
+
+std::vector<compile_result> compile_all(span<std::string_view const> sources, compile_policy const & p, char x)
+{
+    executor pool;
+    return compile_all(sources, pool, p, x);
+}
+
+// Sources are taken in runs, so a task is long enough to hide the cost of scheduling it
+std::vector<compile_result> compile_all(
+    span<std::string_view const> sources, executor & pool, compile_policy const & p, char x
+)
+{
+    std::size_t constexpr run = 64;
+    std::vector<compile_result> results(sources.size());
+    auto const compile = [&](std::size_t i) {
+        auto & result = results[i];
+        try {
+            if ( auto code = expression{std::string{sources[i]}}.compile(x, p) ) {
+                result.handle.emplace(std::move(*code));
+            }
+            else {
+                result.error = "Empty expression";
+            }
+        }
+        catch (std::exception const & e) {
+            result.error = e.what();
+        }
+        catch (...) {
+            result.error = "Unknown error";
+        }
+    };
+    pool.run((sources.size() + run - 1) / run, [&](std::size_t task) {
+        auto const last = std::min(sources.size(), (task + 1) * run);
+        for ( auto i = task * run; i < last; ++i ) {
+            compile(i);
+        }
+    });
+    return results;
+}
+
+} // namespace expr
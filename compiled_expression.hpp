@@ -0,0 +1,105 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : compiled_expression
+ * @created     : Friday October 16, 2026 15:02:09 CEST
+ * @license     : MIT
+ * */
+
+#ifndef COMPILED_EXPRESSION_HPP
+#define COMPILED_EXPRESSION_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include "expression.hpp"
+#include "program.hpp"
+#include "statistics.hpp"
+
+namespace expr
+{
+
+// An immutable handle to a program. Copies share the same program through an
+// atomically counted pointer, and every member function is const: a
+// compiled_expression can be evaluated by any number of threads at the same
+// time, each one with its own parameters if needed
+class compiled_expression
+{
+    std::shared_ptr<program const> _program;
+    std::shared_ptr<expression_stats> _stats;   // only if instrumented
+
+public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    explicit compiled_expression(program p);
+    explicit compiled_expression(std::shared_ptr<program const> p) noexcept;
+
+    // With the parameters bound when the program was compiled
+    const_t operator()(const_t const & x) const noexcept;
+    const_t operator()(const_t const & x, status & s) const noexcept;
+    void operator()(span<const_t const> in, span<const_t> out) const noexcept;
+
+    // With `params` in the order of parameters(); missing ones are the bound ones
+    const_t operator()(const_t const & x, span<const_t const> params) const noexcept;
+    void operator()(span<const_t const> in, span<const_t> out, span<const_t const> params) const noexcept;
+    // The same with the registers in `w`, reserved for code(): no call allocates
+    void operator()(
+        span<const_t const> in, span<const_t> out, span<const_t const> params, workspace & w
+    ) const noexcept;
+
+    // The values over a grid, one row per value of the parameter in `slot`:
+    // out[j * xs.size() + i] is the value at xs[i] with that parameter set to
+    // ys[j], and the others as in `params`. What depends only on the parameters
+    // (an exp(-y^2) in f(x, y)) is computed once per row. Throws
+    // std::invalid_argument if `slot` is not a parameter or `out` has not the
+    // size of the grid
+    void grid(span<const_t const> xs, std::size_t slot, span<const_t const> ys, span<const_t> out) const;
+    void grid(
+        span<const_t const> xs, std::size_t slot, span<const_t const> ys, span<const_t> out,
+        span<const_t const> params
+    ) const;
+
+    // Position of the parameter `name` in the arrays above, or npos
+    std::size_t slot(char name) const noexcept;
+    std::vector<char> const & parameters() const noexcept { return _program->parameters(); }
+
+    // For C interfaces: valid as long as this handle, or a copy of it, is alive
+    c_function c_callable() const noexcept { return to_c_function(*_program); }
+    c_batch c_batch_callable() const noexcept { return to_c_batch(*_program); }
+
+    // A handle to the same program which counts its calls and times them, in
+    // counters registered as `name`; copies of it share the counters. The
+    // original handle stays as fast as before
+    compiled_expression instrument(std::string name, stats_registry & registry = stats_registry::global()) const;
+    expression_stats const * stats() const noexcept { return _stats.get(); }
+
+    program const & code() const noexcept { return *_program; }
+    std::shared_ptr<program const> const & share() const noexcept { return _program; }
+};
+
+class executor;
+
+// The outcome of compiling one source: the handle, or why there is none
+struct compile_result
+{
+    std::optional<compiled_expression> handle;
+    std::string error;
+
+    explicit operator bool() const noexcept { return handle.has_value(); }
+};
+
+// Parse and compile every source over the threads of `pool`, or of a pool made
+// for the call. The results are in the same order as the sources; a source
+// which cannot be compiled gets its error message and does not stop the others
+std::vector<compile_result> compile_all(
+    span<std::string_view const> sources, compile_policy const & p = {}, char x = 'x'
+);
+std::vector<compile_result> compile_all(
+    span<std::string_view const> sources, executor & pool, compile_policy const & p = {}, char x = 'x'
+);
+
+} // namespace expr
+
+#endif /* COMPILED_EXPRESSION_HPP */
@@ -0,0 +1,171 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : disk_cache
+ * @created     : Friday October 16, 2026 17:04:51 CEST
+ * @license     : MIT
+ * */
+
+#include <atomic>
+#include <cstdio>
+#include <vector>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <filesystem>
+#include <unistd.h>
+#include "disk_cache.hpp"
+#include "serialize.hpp"
+
+
+namespace expr
+{
+
+namespace detail
+{
+    // [header][source, padded to 8][serialized program]
+    // The header is stored as in memory: `order` tells apart a file of a machine
+    // with the other endianness, which is then just a miss
+    struct cache_header
+    {
+        char magic[8];
+        std::uint32_t order;
+        std::uint32_t version;
+        std::uint64_t hash;
+        std::uint64_t checksum;             // of everything after the header
+        std::uint8_t  policy;
+        std::uint8_t  variable;
+        std::uint16_t reserved;
+        std::uint32_t source;
+    };
+    static_assert(sizeof(cache_header) == 40);
+
+    constexpr char cache_magic[8] = {'e', 'x', 'p', 'r', 'c', 'a', 'c', 'h'};
+    constexpr std::uint32_t cache_order = 0x01020304;
+
+    // FNV-1a
+    constexpr std::uint64_t fnv_basis = 0xcbf29ce484222325u;
+
+    inline std::uint64_t fnv(std::uint64_t h, void const * data, std::size_t size) noexcept
+    {
+        auto const * bytes = static_cast<unsigned char const *>(data);
+        for ( std::size_t i = 0; i < size; ++i ) {
+            h = (h ^ bytes[i]) * 0x100000001b3u;
+        }
+        return h;
+    }
+
+    std::uint64_t cache_hash(std::string_view source, expression::policy p, char x) noexcept
+    {
+        unsigned char const tail[] = {
+            static_cast<unsigned char>(p), static_cast<unsigned char>(x),
+            static_cast<unsigned char>(compiler_version),       static_cast<unsigned char>(compiler_version >> 8),
+            static_cast<unsigned char>(compiler_version >> 16), static_cast<unsigned char>(compiler_version >> 24),
+        };
+        return fnv(fnv(fnv_basis, source.data(), source.size()), tail, sizeof(tail));
+    }
+
+    constexpr std::uint64_t padded(std::uint64_t n) noexcept { return (n + 7) / 8 * 8; }
+} // namespace detail
+
+disk_cache::disk_cache(std::string directory) :
+    _directory{std::move(directory)}
+{
+    std::filesystem::create_directories(_directory);
+}
+
+std::string disk_cache::path(std::string_view source, expression::policy p, char x) const
+{
+    char name[24];
+    std::snprintf(name, sizeof(name), "%016llx.expr",
+        static_cast<unsigned long long>(detail::cache_hash(source, p, x)));
+    return (std::filesystem::path{_directory} / name).string();
+}
+
+std::optional<program> disk_cache::load(std::string_view source, expression::policy p, char x) const
+{
+    mapped_file file{this->path(source, p, x)};
+    auto const bytes = file.bytes();
+    if ( bytes.size() < sizeof(detail::cache_header) ) {
+        return {};
+    }
+    detail::cache_header h;
+    std::memcpy(&h, bytes.data(), sizeof(h));
+    if (
+        std::memcmp(h.magic, detail::cache_magic, sizeof(h.magic)) != 0 ||
+        h.order != detail::cache_order || h.version != compiler_version ||
+        h.hash != detail::cache_hash(source, p, x) ||
+        h.policy != static_cast<std::uint8_t>(p) || h.variable != static_cast<std::uint8_t>(x) ||
+        h.source != source.size() || bytes.size() < sizeof(h) + detail::padded(h.source) ||
+        h.checksum != detail::fnv(detail::fnv_basis, bytes.data() + sizeof(h), bytes.size() - sizeof(h))
+    ) {
+        return {};
+    }
+
+    auto const body = bytes.subspan(sizeof(h), bytes.size() - sizeof(h));
+    // Two sources with the same hash
+    if ( std::string_view{reinterpret_cast<char const *>(body.data()), h.source} != source ) {
+        return {};
+    }
+    auto const offset = detail::padded(h.source);
+    try {
+        return deserialize(body.subspan(offset, body.size() - offset));
+    }
+    catch (std::invalid_argument const &) {
+        return {};
+    }
+}
+
+bool disk_cache::store(std::string_view source, expression::policy p, char x, program const & code) const
+{
+    static std::atomic<unsigned> counter{0};
+
+    std::vector<std::byte> body(detail::padded(source.size()));
+    std::memcpy(body.data(), source.data(), source.size());
+    auto const serialized = serialize(code);
+    body.insert(body.end(), serialized.begin(), serialized.end());
+
+    detail::cache_header h;
+    std::memcpy(h.magic, detail::cache_magic, sizeof(h.magic));
+    h.order    = detail::cache_order;
+    h.version  = compiler_version;
+    h.hash     = detail::cache_hash(source, p, x);
+    h.checksum = detail::fnv(detail::fnv_basis, body.data(), body.size());
+    h.policy   = static_cast<std::uint8_t>(p);
+    h.variable = static_cast<std::uint8_t>(x);
+    h.reserved = 0;
+    h.source   = static_cast<std::uint32_t>(source.size());
+
+    auto const target = this->path(source, p, x);
+    auto const temporary = target + '.' + std::to_string(::getpid()) + '.' + std::to_string(counter++);
+    {
+        std::ofstream out{temporary, std::ios::binary | std::ios::trunc};
+        out.write(reinterpret_cast<char const *>(&h), sizeof(h));
+        out.write(reinterpret_cast<char const *>(body.data()), static_cast<std::streamsize>(body.size()));
+        if ( ! out.flush() ) {
+            out.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if ( std::rename(temporary.c_str(), target.c_str()) != 0 ) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Storing is best effort: a read-only or full disk only costs the next start
+std::shared_ptr<program const> disk_cache::get(std::string_view source, expression::policy p, char x) const
+{
+    if ( auto stored = this->load(source, p, x) ) {
+        return std::make_shared<program const>(std::move(*stored));
+    }
+    auto compiled = expression{p, std::string{source}}.compile(x);
+    if ( ! compiled ) {
+        return nullptr;
+    }
+    this->store(source, p, x, *compiled);
+    return std::make_shared<program const>(std::move(*compiled));
+}
+
+} // namespace expr
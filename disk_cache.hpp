@@ -0,0 +1,48 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : disk_cache
+ * @created     : Friday October 16, 2026 16:58:17 CEST
+ * @license     : MIT
+ * */
+
+#ifndef DISK_CACHE_HPP
+#define DISK_CACHE_HPP
+
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include "expression.hpp"
+#include "program.hpp"
+
+namespace expr
+{
+
+// Compiled programs kept in a directory, one file each, named after a hash of
+// the source, the policy, the variable and the compiler version: a new process
+// maps the file in instead of parsing and optimizing again. A file written by
+// another compiler version, truncated or corrupted is ignored and replaced.
+// Files are written aside and renamed, so processes can share the directory
+class disk_cache
+{
+    std::string _directory;
+
+public:
+    // The directory is created if it does not exist
+    explicit disk_cache(std::string directory);
+
+    // The stored program if there is a valid one, otherwise it is compiled and
+    // stored; nullptr for an empty expression. Parsing errors are thrown
+    std::shared_ptr<program const> get(std::string_view source, expression::policy p, char x) const;
+
+    std::optional<program> load(std::string_view source, expression::policy p, char x) const;
+    bool store(std::string_view source, expression::policy p, char x, program const & code) const;
+
+    std::string path(std::string_view source, expression::policy p, char x) const;
+    std::string const & directory() const noexcept { return _directory; }
+};
+
+} // namespace expr
+
+#endif /* DISK_CACHE_HPP */
@@ -0,0 +1,532 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : egraph
+ * @created     : Friday October 16, 2026 22:14:37 CEST
+ * @license     : MIT
+ * */
+
+#include <map>
+#include <cmath>
+#include <tuple>
+#include <chrono>
+#include <limits>
+#include <vector>
+#include <cstring>
+#include <optional>
+#include <algorithm>
+#include <functional>
+#include "program.hpp"
+
+
+namespace expr
+{
+
+namespace detail
+{
+    using eclass = std::uint32_t;
+
+    // An operation on classes of equivalent subexpressions. For a constant `bits`
+    // holds its value, for a variable or a parameter `a` is its index
+    struct enode
+    {
+        opcode op;
+        eclass a = 0;
+        eclass b = 0;
+        eclass c = 0;
+        std::uint64_t bits = 0;
+
+        auto key() const noexcept { return std::make_tuple(op, a, b, c, bits); }
+        friend bool operator<(enode const & x, enode const & y) noexcept { return x.key() < y.key(); }
+        friend bool operator==(enode const & x, enode const & y) noexcept { return x.key() == y.key(); }
+    };
+
+    inline std::uint64_t bits_of(const_t value) noexcept
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        return bits;
+    }
+
+    inline const_t value_of(std::uint64_t bits) noexcept
+    {
+        const_t value;
+        std::memcpy(&value, &bits, sizeof value);
+        return value;
+    }
+
+    inline bool integer(const_t v) noexcept
+    {
+        return std::isfinite(v) && v == std::trunc(v) && std::abs(v) < 0x1p53;
+    }
+
+    // Whether 1/v is exact, as in reduce()
+    inline bool power_of_two(const_t v) noexcept
+    {
+        int e;
+        return std::isfinite(v) && v != 0 && std::abs(std::frexp(v, &e)) == 0.5 && std::isnormal(1 / v);
+    }
+
+    // An operation on constants, as the exact kernels compute it
+    std::optional<const_t> evaluate(opcode op, const_t a, const_t b) noexcept
+    {
+        switch (op) {
+            case opcode::add:  return a + b;
+            case opcode::sub:  return a - b;
+            case opcode::mul:  return a * b;
+            case opcode::div:  return a / b;
+            case opcode::mod:  return modulus(a, b);
+            case opcode::pow:  return std::pow(a, b);
+            case opcode::sin:  return std::sin(a);
+            case opcode::cos:  return std::cos(a);
+            case opcode::tan:  return std::tan(a);
+            case opcode::asin: return std::asin(a);
+            case opcode::acos: return std::acos(a);
+            case opcode::atan: return std::atan(a);
+            case opcode::exp:  return std::exp(a);
+            case opcode::ln:   return std::log(a);
+            case opcode::abs:  return std::abs(a);
+            case opcode::sqrt: return std::sqrt(a);
+            case opcode::cbrt: return std::cbrt(a);
+            default:           return {};
+        }
+    }
+
+    // Classes of subexpressions known to be equal, each one with all the forms
+    // found for it. The forms refer to classes, not to other forms, so a single
+    // rewrite of a subexpression is seen by every expression using it
+    class egraph
+    {
+        std::vector<eclass> _parent;                    // union-find
+        std::vector<std::vector<enode>> _nodes;         // of the classes which are roots
+        std::vector<std::optional<const_t>> _value;     // of the classes which are constants
+        std::map<enode, eclass> _memo;
+        std::size_t _size = 0;
+
+        void canonicalize(enode & n) const noexcept
+        {
+            auto const k = arity(n.op);
+            if ( k > 0 ) { n.a = find(n.a); }
+            if ( k > 1 ) { n.b = find(n.b); }
+            if ( k > 2 ) { n.c = find(n.c); }
+        }
+
+        std::optional<const_t> fold(enode const & n) const noexcept
+        {
+            auto const k = arity(n.op);
+            if ( k == 0 || k > 2 ) {
+                return {};
+            }
+            auto const a = _value[find(n.a)];
+            auto const b = k > 1 ? _value[find(n.b)] : std::optional<const_t>{0};
+            return a && b ? evaluate(n.op, *a, *b) : std::nullopt;
+        }
+
+    public:
+        eclass find(eclass x) const noexcept
+        {
+            while ( _parent[x] != x ) { x = _parent[x]; }
+            return x;
+        }
+
+        eclass add(enode n)
+        {
+            canonicalize(n);
+            if ( auto const it = _memo.find(n); it != _memo.end() ) {
+                return find(it->second);
+            }
+            auto const x = static_cast<eclass>(_parent.size());
+            _parent.push_back(x);
+            _nodes.push_back({ n });
+            _value.push_back(n.op == opcode::constant ? std::optional{value_of(n.bits)} : std::nullopt);
+            _memo.emplace(n, x);
+            ++_size;
+            return x;
+        }
+
+        eclass number(const_t v) { return this->add({ opcode::constant, 0, 0, 0, bits_of(v) }); }
+
+        bool merge(eclass x, eclass y)
+        {
+            x = find(x);
+            y = find(y);
+            if ( x == y ) {
+                return false;
+            }
+            if ( _nodes[x].size() < _nodes[y].size() ) {
+                std::swap(x, y);
+            }
+            _parent[y] = x;
+            _nodes[x].insert(_nodes[x].end(), _nodes[y].begin(), _nodes[y].end());
+            _nodes[y].clear();
+            _nodes[y].shrink_to_fit();
+            if ( ! _value[x] ) {
+                _value[x] = _value[y];
+            }
+            return true;
+        }
+
+        // After the merges the forms of a class can refer to classes which are
+        // gone, and forms equal in every operand can be in different classes:
+        // those are merged too, until there are no more of them. A class whose
+        // operands are constants gets its value
+        void rebuild()
+        {
+            while ( true ) {
+                std::vector<std::pair<eclass, eclass>> same;
+                std::vector<eclass> folded;
+                std::map<enode, eclass> memo;
+                _size = 0;
+                for ( eclass x = 0; x < _parent.size(); ++x ) {
+                    if ( _parent[x] != x ) {
+                        continue;
+                    }
+                    auto & nodes = _nodes[x];
+                    for ( auto & n : nodes ) { canonicalize(n); }
+                    std::sort(nodes.begin(), nodes.end());
+                    nodes.erase(std::unique(nodes.begin(), nodes.end()), nodes.end());
+                    _size += nodes.size();
+                    for ( auto const & n : nodes ) {
+                        auto const [it, inserted] = memo.try_emplace(n, x);
+                        if ( ! inserted && it->second != x ) {
+                            same.emplace_back(it->second, x);
+                        }
+                        if ( ! _value[x] ) {
+                            if ( auto const v = fold(n) ) {
+                                _value[x] = v;
+                                folded.push_back(x);
+                            }
+                        }
+                    }
+                }
+                _memo = std::move(memo);
+                for ( auto x : folded ) {
+                    same.emplace_back(x, this->number(*_value[x]));
+                }
+                if ( same.empty() ) {
+                    return;
+                }
+                for ( auto const & [x, y] : same ) {
+                    this->merge(x, y);
+                }
+            }
+        }
+
+        std::vector<enode> const & nodes(eclass x) const noexcept { return _nodes[find(x)]; }
+        std::optional<const_t> value(eclass x) const noexcept { return _value[find(x)]; }
+        std::size_t classes() const noexcept { return _parent.size(); }
+        std::size_t size() const noexcept { return _size; }
+    };
+
+    // A form found equal to the class `target`, to be added once the search is over
+    struct rewrite
+    {
+        eclass target;
+        std::function<eclass(egraph &)> build;
+    };
+
+    template <typename F>
+    inline void each(egraph const & g, eclass x, opcode op, F f)
+    {
+        for ( auto const & n : g.nodes(x) ) {
+            if ( n.op == op ) { f(n); }
+        }
+    }
+
+    // The rules matching the form `n` of the class `x`, up to `limit` of them in
+    // all. Commutativity puts every operand of an addition or of a product on both
+    // sides, so each rule matches a single order of its operands. Both sides of a
+    // rule have to agree at infinities and NaN too: sin(p)^2+cos(p)^2 is NaN
+    // where 1 is not, and exp(p)*exp(q) is NaN where exp(p+q) is finite, so
+    // those are not rules
+    void search(egraph const & g, eclass x, enode const & n, std::vector<rewrite> & found, std::size_t limit)
+    {
+        using op = opcode;
+        auto const is = [&](eclass y, const_t v) {
+            auto const w = g.value(y);
+            return w && *w == v;
+        };
+        auto const to = [&](auto build) {
+            if ( found.size() < limit ) { found.push_back({ x, build }); }
+        };
+        auto const a = n.a;
+        auto const b = n.b;
+        // Nothing is cheaper than a constant: rewriting one only grows the graph
+        if ( g.value(x) ) {
+            return;
+        }
+
+        switch (n.op) {
+            case op::add:
+                to([=](egraph & e) { return e.add({ op::add, b, a }); });
+                each(g, a, op::add, [&](enode const & l) {       // (p+q)+b = p+(q+b)
+                    to([=, p = l.a, q = l.b](egraph & e) { return e.add({ op::add, p, e.add({ op::add, q, b }) }); });
+                });
+                if ( is(b, 0) ) {
+                    to([=](egraph &) { return a; });
+                }
+                if ( a == b ) {                                 // a+a = 2*a
+                    to([=](egraph & e) { return e.add({ op::mul, e.number(2), a }); });
+                }
+                each(g, b, op::mul, [&](enode const & r) {       // a+a*q = a*(1+q)
+                    if ( r.a == a ) {
+                        to([=, q = r.b](egraph & e) { return e.add({ op::mul, a, e.add({ op::add, e.number(1), q }) }); });
+                    }
+                });
+                each(g, a, op::mul, [&](enode const & l) {
+                    each(g, b, op::mul, [&](enode const & r) {
+                        if ( l.a == r.a ) {                     // p*q+p*s = p*(q+s)
+                            to([=, p = l.a, q = l.b, s = r.b](egraph & e) { return e.add({ op::mul, p, e.add({ op::add, q, s }) }); });
+                        }
+                    });
+                });
+                break;
+            case op::sub:
+                if ( is(b, 0) ) {
+                    to([=](egraph &) { return a; });
+                }
+                each(g, a, op::mul, [&](enode const & l) {
+                    each(g, b, op::mul, [&](enode const & r) {
+                        if ( l.a == r.a ) {                     // p*q-p*s = p*(q-s)
+                            to([=, p = l.a, q = l.b, s = r.b](egraph & e) { return e.add({ op::mul, p, e.add({ op::sub, q, s }) }); });
+                        }
+                        if ( l.a == l.b && r.a == r.b ) {       // cos(p)^2-sin(p)^2 = cos(2*p)
+                            each(g, l.a, op::cos, [&](enode const & c) {
+                                each(g, r.a, op::sin, [&](enode const & s) {
+                                    if ( s.a == c.a ) {
+                                        to([=, p = c.a](egraph & e) { return e.add({ op::cos, e.add({ op::mul, e.number(2), p }) }); });
+                                    }
+                                });
+                            });
+                        }
+                    });
+                });
+                break;
+            case op::mul:
+                to([=](egraph & e) { return e.add({ op::mul, b, a }); });
+                each(g, a, op::mul, [&](enode const & l) {       // (p*q)*b = p*(q*b)
+                    to([=, p = l.a, q = l.b](egraph & e) { return e.add({ op::mul, p, e.add({ op::mul, q, b }) }); });
+                });
+                if ( is(b, 1) ) {
+                    to([=](egraph &) { return a; });
+                }
+                if ( a == b ) {
+                    to([=](egraph & e) { return e.add({ op::pow, a, e.number(2) }); });
+                }
+                each(g, b, op::add, [&](enode const & r) {       // a*(p+q) = a*p+a*q
+                    to([=, p = r.a, q = r.b](egraph & e) { return e.add({ op::add, e.add({ op::mul, a, p }), e.add({ op::mul, a, q }) }); });
+                });
+                each(g, b, op::div, [&](enode const & r) {       // a*(p/q) = (a*p)/q
+                    to([=, p = r.a, q = r.b](egraph & e) { return e.add({ op::div, e.add({ op::mul, a, p }), q }); });
+                });
+                each(g, a, op::abs, [&](enode const & l) {
+                    each(g, b, op::abs, [&](enode const & r) {  // |p|*|q| = |p*q|
+                        to([=, p = l.a, q = r.a](egraph & e) { return e.add({ op::abs, e.add({ op::mul, p, q }) }); });
+                    });
+                });
+                each(g, a, op::sin, [&](enode const & l) {
+                    each(g, b, op::cos, [&](enode const & r) {  // sin(p)*cos(p) = sin(2*p)/2
+                        if ( l.a == r.a ) {
+                            to([=, p = l.a](egraph & e) {
+                                return e.add({ op::mul, e.number(0.5), e.add({ op::sin, e.add({ op::mul, e.number(2), p }) }) });
+                            });
+                        }
+                    });
+                });
+                // p^k*p^m = p^(k+m) and p^k*p = p^(k+1), for integers only: with
+                // a negative base the others are not defined on the same values.
+                // Not negative either: p^-1*p is NaN at 0, where p^0 is 1
+                each(g, a, op::pow, [&](enode const & l) {
+                    auto const k = g.value(l.b);
+                    if ( ! k || ! integer(*k) || *k < 0 ) {
+                        return;
+                    }
+                    if ( l.a == b ) {
+                        to([=, p = l.a, k = *k](egraph & e) { return e.add({ op::pow, p, e.number(k + 1) }); });
+                    }
+                    each(g, b, op::pow, [&](enode const & r) {
+                        auto const m = g.value(r.b);
+                        if ( l.a == r.a && m && integer(*m) && *m >= 0 ) {
+                            to([=, p = l.a, k = *k, m = *m](egraph & e) { return e.add({ op::pow, p, e.number(k + m) }); });
+                        }
+                    });
+                });
+                break;
+            case op::div:
+                if ( is(b, 1) ) {
+                    to([=](egraph &) { return a; });
+                }
+                if ( auto const v = g.value(b); v && power_of_two(*v) ) {   // a/v = a*(1/v), exact
+                    to([=, v = *v](egraph & e) { return e.add({ op::mul, a, e.number(1 / v) }); });
+                }
+                each(g, a, op::div, [&](enode const & l) {       // (p/q)/b = p/(q*b)
+                    to([=, p = l.a, q = l.b](egraph & e) { return e.add({ op::div, p, e.add({ op::mul, q, b }) }); });
+                });
+                each(g, a, op::sin, [&](enode const & l) {
+                    each(g, b, op::cos, [&](enode const & r) {  // sin(p)/cos(p) = tan(p)
+                        if ( l.a == r.a ) {
+                            to([=, p = l.a](egraph & e) { return e.add({ op::tan, p }); });
+                        }
+                    });
+                });
+                break;
+            case op::pow:
+                if ( is(b, 1) ) {
+                    to([=](egraph &) { return a; });
+                }
+                if ( is(b, 2) ) {
+                    to([=](egraph & e) { return e.add({ op::mul, a, a }); });
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    // The cheapest form of every class. A class of a constant is a constant; a
+    // small price on every instruction prefers the shorter of two forms of the
+    // same cost and makes the choice acyclic. The costs only decrease, so the
+    // loop ends
+    std::vector<enode> cheapest(egraph const & g, accuracy level)
+    {
+        auto constexpr step = 1e-3;
+        std::vector<double> best(g.classes(), std::numeric_limits<double>::infinity());
+        std::vector<enode> choice(g.classes());
+        for ( auto changed = true; changed; ) {
+            changed = false;
+            for ( eclass x = 0; x < g.classes(); ++x ) {
+                if ( g.find(x) != x ) {
+                    continue;
+                }
+                if ( auto const v = g.value(x) ) {
+                    if ( best[x] != 0 ) {
+                        best[x] = 0;
+                        choice[x] = { opcode::constant, 0, 0, 0, bits_of(*v) };
+                        changed = true;
+                    }
+                    continue;
+                }
+                for ( auto const & n : g.nodes(x) ) {
+                    auto total = cost(n.op, level) + step;
+                    auto const k = arity(n.op);
+                    if ( k > 0 ) { total += best[g.find(n.a)]; }
+                    if ( k > 1 ) { total += best[g.find(n.b)]; }
+                    if ( k > 2 ) { total += best[g.find(n.c)]; }
+                    if ( total < best[x] ) {
+                        best[x] = total;
+                        choice[x] = n;
+                        changed = true;
+                    }
+                }
+            }
+        }
+        return choice;
+    }
+
+    // The instructions of the chosen forms, operands first: each class is computed once
+    std::uint32_t extract(
+        egraph const & g, std::vector<enode> const & choice, eclass x,
+        std::vector<instruction> & code, std::vector<const_t> & constants, std::vector<std::uint32_t> & reg
+    )
+    {
+        x = g.find(x);
+        if ( reg[x] != std::numeric_limits<std::uint32_t>::max() ) {
+            return reg[x];
+        }
+        auto const & n = choice[x];
+        instruction ins{ n.op };
+        switch (arity(n.op)) {
+            case 3: ins.c = extract(g, choice, n.c, code, constants, reg); [[fallthrough]];
+            case 2: ins.b = extract(g, choice, n.b, code, constants, reg); [[fallthrough]];
+            case 1: ins.a = extract(g, choice, n.a, code, constants, reg); break;
+            default:
+                if ( n.op == opcode::constant ) {
+                    constants.push_back(value_of(n.bits));
+                    ins.a = static_cast<std::uint32_t>(constants.size() - 1);
+                }
+                else {
+                    ins.a = n.a;
+                }
+        }
+        code.push_back(ins);
+        return reg[x] = static_cast<std::uint32_t>(code.size() - 1);
+    }
+} // namespace detail
+
+// The rules run on every form at once, then the forms they give are added, and
+// so on until they add nothing or the budget is over. The program found replaces
+// this one only if it is cheaper
+program & program::saturate(saturation_budget const & budget)
+{
+    using clock = std::chrono::steady_clock;
+    auto const deadline = clock::now() + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(budget.seconds));
+    // Before fuse: the second result of a sincos is not a value of its own
+    auto const paired = std::any_of(_code.begin(), _code.end(), [](auto const & ins) { return ins.op == opcode::sincos; });
+    if ( _code.empty() || paired ) {
+        return *this;
+    }
+
+    detail::egraph g;
+    std::vector<detail::eclass> of(_code.size());
+    for ( std::size_t i = 0; i < _code.size(); ++i ) {
+        auto const & ins = _code[i];
+        detail::enode n{ ins.op };
+        switch (arity(ins.op)) {
+            case 3: n.c = of[ins.c]; [[fallthrough]];
+            case 2: n.b = of[ins.b]; [[fallthrough]];
+            case 1: n.a = of[ins.a]; break;
+            default:
+                if ( ins.op == opcode::constant ) { n.bits = detail::bits_of(_constants[ins.a]); }
+                else                              { n.a = ins.a; }
+        }
+        of[i] = g.add(n);
+    }
+    g.rebuild();
+
+    auto const over = [&] { return g.size() >= budget.nodes || clock::now() >= deadline; };
+    for ( std::size_t iteration = 0; iteration < budget.iterations && ! over(); ++iteration ) {
+        // The pairs of forms matched by some rules grow with the square of the
+        // graph: past the budget of nodes, most of them would be thrown away
+        std::vector<detail::rewrite> found;
+        for ( detail::eclass x = 0; x < g.classes() && found.size() < budget.nodes && ! over(); ++x ) {
+            if ( g.find(x) != x ) {
+                continue;
+            }
+            for ( auto const & n : g.nodes(x) ) {
+                detail::search(g, x, n, found, budget.nodes);
+            }
+        }
+        auto grown = false;
+        for ( auto const & r : found ) {
+            if ( over() ) {
+                break;
+            }
+            grown = g.merge(r.target, r.build(g)) || grown;
+        }
+        g.rebuild();
+        if ( ! grown ) {
+            break;
+        }
+    }
+
+    std::vector<instruction> code;
+    std::vector<const_t> constants;
+    std::vector<std::uint32_t> reg(g.classes(), std::numeric_limits<std::uint32_t>::max());
+    detail::extract(g, detail::cheapest(g, _accuracy), of.back(), code, constants, reg);
+
+    // The original, with its repetitions counted once as share() would leave it
+    auto shared = *this;
+    shared.share();
+    auto const total = [&](std::vector<instruction> const & c) {
+        double result = 0;
+        for ( auto const & ins : c ) { result += cost(ins.op, _accuracy); }
+        return result;
+    };
+    if ( total(code) < total(shared._code) ) {
+        _code      = std::move(code);
+        _constants = std::move(constants);
+        this->compact();
+    }
+    return *this;
+}
+
+} // namespace expr
@@ -0,0 +1,138 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : executor
+ * @created     : Friday October 16, 2026 14:11:20 CEST
+ * @license     : MIT
+ * */
+
+#include <exception>
+#include <algorithm>
+#include "executor.hpp"
+
+
+namespace expr
+{
+
+executor::executor(std::size_t threads)
+{
+    threads = std::max<std::size_t>(threads, 1);
+    for ( std::size_t i = 0; i < threads; ++i ) {
+        _queues.push_back(std::make_unique<queue>());
+    }
+    for ( std::size_t i = 0; i < threads; ++i ) {
+        _threads.emplace_back([this, i] { this->work(i); });
+    }
+}
+
+executor::~executor()
+{
+    {
+        std::lock_guard lock{_mutex};
+        _stop = true;
+    }
+    _wake.notify_all();
+    for ( auto & thread : _threads ) {
+        thread.join();
+    }
+}
+
+void executor::push(std::size_t index, std::function<void()> task)
+{
+    {
+        std::lock_guard lock{_queues[index]->mutex};
+        _queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard lock{_mutex};
+        ++_pending;
+    }
+    _wake.notify_one();
+}
+
+// Own queue from the back, the others from the front
+bool executor::pop(std::size_t index, std::function<void()> & task)
+{
+    auto const n = _queues.size();
+    for ( std::size_t i = 0; i < n; ++i ) {
+        auto & q = *_queues[(index + i) % n];
+        std::lock_guard lock{q.mutex};
+        if ( q.tasks.empty() ) {
+            continue;
+        }
+        if ( i == 0 ) {
+            task = std::move(q.tasks.back());
+            q.tasks.pop_back();
+        }
+        else {
+            task = std::move(q.tasks.front());
+            q.tasks.pop_front();
+        }
+        --_pending;
+        return true;
+    }
+    return false;
+}
+
+void executor::work(std::size_t index)
+{
+    std::function<void()> task;
+    while ( true ) {
+        if ( this->pop(index, task) ) {
+            task();
+            continue;
+        }
+        std::unique_lock lock{_mutex};
+        _wake.wait(lock, [&] { return _stop || _pending > 0; });
+        if ( _stop ) {
+            return;
+        }
+    }
+}
+
+void executor::run(std::size_t n, std::function<void(std::size_t)> const & task)
+{
+    struct state
+    {
+        std::atomic<std::size_t> remaining;
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+    } shared{ {n}, {}, {}, {} };
+
+    // Under the lock: `shared` must outlive the last notification
+    auto finish = [&shared] {
+        std::lock_guard lock{shared.mutex};
+        if ( --shared.remaining == 0 ) {
+            shared.done.notify_all();
+        }
+    };
+
+    // Contiguous tasks go to the same queue, so a thread walks memory in order
+    auto const queues = _queues.size();
+    auto const first  = _next++;
+    for ( std::size_t i = 0; i < n; ++i ) {
+        this->push((first + i * queues / n) % queues, [&task, &shared, &finish, i] {
+            try {
+                task(i);
+            }
+            catch (...) {
+                std::lock_guard lock{shared.mutex};
+                if ( ! shared.error ) { shared.error = std::current_exception(); }
+            }
+            finish();
+        });
+    }
+
+    // Help instead of waiting
+    std::function<void()> job;
+    while ( shared.remaining > 0 && this->pop(first % queues, job) ) {
+        job();
+    }
+    std::unique_lock lock{shared.mutex};
+    shared.done.wait(lock, [&] { return shared.remaining == 0; });
+    if ( shared.error ) {
+        std::rethrow_exception(shared.error);
+    }
+}
+
+} // namespace expr
@@ -0,0 +1,63 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : executor
+ * @created     : Friday October 16, 2026 14:05:51 CEST
+ * @license     : MIT
+ * */
+
+#ifndef EXECUTOR_HPP
+#define EXECUTOR_HPP
+
+#include <mutex>
+#include <deque>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <functional>
+#include <condition_variable>
+
+namespace expr
+{
+
+// A pool of threads, each one with its own queue: a thread works on the back of
+// its queue and, when it is empty, steals from the front of the others
+class executor
+{
+    struct queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<queue>> _queues;
+    std::vector<std::thread> _threads;
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    // Tasks queued and not taken yet. A task can be taken before push() counts
+    // it, so the count can be negative for a moment: that means nothing to do
+    std::atomic<std::ptrdiff_t> _pending{0};
+    std::atomic<std::size_t> _next{0};
+    bool _stop = false;
+
+public:
+    explicit executor(std::size_t threads = std::thread::hardware_concurrency());
+    ~executor();
+    executor(executor const &) = delete;
+    executor & operator=(executor const &) = delete;
+
+    // Run task(0) ... task(n-1) and return when all of them are done; the calling
+    // thread helps. The first exception thrown by a task is rethrown here
+    void run(std::size_t n, std::function<void(std::size_t)> const & task);
+
+    std::size_t size() const noexcept { return _threads.size(); }
+private:
+    void push(std::size_t index, std::function<void()> task);
+    bool pop(std::size_t index, std::function<void()> & task);
+    void work(std::size_t index);
+};
+
+} // namespace expr
+
+#endif /* EXECUTOR_HPP */
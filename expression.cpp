@@ -6,9 +6,18 @@
  * */
 
 #include <regex>
+#include <chrono>
 #include <cmath>
+#include <stack>
 #include <cctype>
+#include <cstdio>
+#include <limits>
+#include <algorithm>
 #include "expression.hpp"
+#include "program.hpp"
+#include "approximation.hpp"
+#include "executor.hpp"
+#include "allocation_counter.hpp"
 
 
 namespace expr
@@ -49,7 +58,7 @@ namespace detail
         if ( x == '^' ) {
             return 2;
         }
-        if ( x == 's' || x == 'c' || x == 't' || x == 'e' || x == 'l' || x == 'a' || x == 'v') {
+        if ( x == 's' || x == 'c' || x == 't' || x == 'e' || x == 'l' || x == 'a' || x == 'v' || x == '|' ) {
             return 3;
         }
         return -1;
@@ -71,7 +80,7 @@ namespace detail
         auto constexpr minus      = [](const_t const & a, const_t const & b) { return a - b; };
         auto constexpr multiplies = [](const_t const & a, const_t const & b) { return a * b; };
         auto constexpr divides    = [](const_t const & a, const_t const & b) { return a / b; };
-        auto constexpr modulus    = [](const_t const & a, const_t const & b) { return static_cast<long>(a) % static_cast<long>(b); };
+        auto constexpr modulus    = [](const_t const & a, const_t const & b) { return expr::modulus(a, b); };
         auto constexpr pow        = [](const_t const & a, const_t const & b) { return std::pow(a,b); };
 
         auto constexpr sin        = [](const_t const & a) { return std::sin(a); };
@@ -96,6 +105,40 @@ namespace detail
         //log10
     } // namespace function
 
+    // Compositions built by the optimizer; they are named so that the compiler can see through them
+    struct unary_of_unary
+    {
+        unary_f f, g;
+        const_t operator()(const_t const & a) const { return f(g(a)); }
+    };
+
+    struct unary_of_binary
+    {
+        unary_f f;
+        binary_f g;
+        const_t operator()(const_t const & a, const_t const & b) const { return f(g(a, b)); }
+    };
+
+    struct binary_of_first
+    {
+        binary_f f;
+        unary_f g;
+        const_t operator()(const_t const & a, const_t const & b) const { return f(g(a), b); }
+    };
+
+    struct binary_of_second
+    {
+        binary_f f;
+        unary_f g;
+        const_t operator()(const_t const & a, const_t const & b) const { return f(a, g(b)); }
+    };
+
+    template <typename Function, typename F>
+    inline bool holds(Function const & fn, F const &) noexcept
+    {
+        return fn.template target<F>() != nullptr;
+    }
+
     inline std::function<double(double, double)> sign_to_binary(char ch)
     {
         switch (ch) {
@@ -192,6 +235,7 @@ expression::expression(expression::policy p, std::string && source)
 
 std::vector<variant_t> expression::parse(std::string && src)
 {
+    EXPR_PHASE(parse);
     if ( src.empty() ) {
         return { const_t{0} };
     }
@@ -380,6 +424,7 @@ expression & expression::build(expression::policy p, std::string && src)
 
 expression & expression::build_impl(std::string && src)
 {
+    EXPR_PHASE(build);
     auto symbols = parse(std::move(src));
     auto it      = symbols.crbegin();
     auto end     = symbols.crend();
@@ -432,6 +477,7 @@ expression & expression::build_impl(std::string && src)
 
 expression & expression::optimize()
 {
+    EXPR_PHASE(optimize);
     if ( _head ) {
         this->optimize_impl(_head);
     }
@@ -449,21 +495,18 @@ void expression::optimize_impl(std::shared_ptr<node> & node)
             node->content = const_t{eval_impl(node)};
         }
         //Compose [f]->[g->[x,y],h->[z,w]] into [f.°h->[z,w]]->g[x,y] and then reiterate as unary
+        //The right leaf holds the first operand, the left one the second
         else
         {
             if ( std::holds_alternative<unary_f>(node->right->content) )
             {
                 auto left  = std::move(node->left);
                 auto right = std::move(node->right);
-                auto new_function =
-                [
-                    f = std::move(std::get<binary_f>(node->content)),
-                    g = std::move(std::get<unary_f>(right->content))
-                ]
-                (const_t const & a, const_t const & b) {
-                    return f(a, g(b));
+                auto new_function = detail::binary_of_first{
+                    std::move(std::get<binary_f>(node->content)),
+                    std::move(std::get<unary_f>(right->content))
                 };
-                node = std::make_shared<expr::node>(std::move(new_function));
+                node = std::make_shared<expr::node>(binary_f{std::move(new_function)});
                 node->left  = std::move(left);
                 node->right = std::move(right->left);
             }
@@ -471,17 +514,13 @@ void expression::optimize_impl(std::shared_ptr<node> & node)
             {
                 auto left  = std::move(node->left);
                 auto right = std::move(node->right);
-                auto new_function =
-                [
-                    f = std::move(std::get<binary_f>(node->content)),
-                    g = std::move(std::get<unary_f> (left->content))
-                ]
-                (const_t const & a, const_t const & b) {
-                    return f(g(a), b);
+                auto new_function = detail::binary_of_second{
+                    std::move(std::get<binary_f>(node->content)),
+                    std::move(std::get<unary_f> (left->content))
                 };
-                node = std::make_shared<expr::node>(std::move(new_function));
-                node->left  = std::move(left->left); //std::move(left);
-                node->right = std::move(right); //std::move(right->left);
+                node = std::make_shared<expr::node>(binary_f{std::move(new_function)});
+                node->left  = std::move(left->left);
+                node->right = std::move(right);
             }
         }
     }
@@ -497,13 +536,11 @@ void expression::optimize_impl(std::shared_ptr<node> & node)
             //Compose [f]->[g]->[x] into [f°g]->[x]
             if ( std::holds_alternative<unary_f>(node->left->content) ) {
                 auto tmp = std::move(node->left);
-                auto new_function =
-                [
-                    f = std::get<unary_f>(node->content),
-                    g = std::get<unary_f>( tmp->content)
-                ]
-                (const_t const & a) {
-                    return f(g(a));
+                auto new_function = unary_f{
+                    detail::unary_of_unary{
+                        std::get<unary_f>(node->content),
+                        std::get<unary_f>( tmp->content)
+                    }
                 };
                 node = std::make_shared<expr::node>(std::move(new_function));
                 node->left = std::move(tmp->left);
@@ -512,12 +549,9 @@ void expression::optimize_impl(std::shared_ptr<node> & node)
             else if ( std::holds_alternative<binary_f>(node->left->content) ) {
                 auto tmp = std::move(node->left);
                 auto new_function = binary_f{
-                    [
-                        f = std::get<unary_f>(node->content),
-                        g = std::get<binary_f>( tmp->content)
-                    ]
-                    (const_t const & a, const_t const & b) {
-                        return f(g(a, b));
+                    detail::unary_of_binary{
+                        std::get<unary_f>(node->content),
+                        std::get<binary_f>( tmp->content)
                     }
                 };
                 node = std::make_shared<expr::node>(std::move(new_function));
@@ -528,35 +562,74 @@ void expression::optimize_impl(std::shared_ptr<node> & node)
     }
 }
 
-std::optional<const_t> expression::eval() const
+std::optional<const_t> expression::eval() const noexcept
 {
+    EXPR_PHASE(eval);
     if ( ! _head ) { return {}; }
     return this->eval_impl(_head);
 }
 
-std::optional<const_t> expression::eval(char ch, const_t const & value) const
+std::optional<const_t> expression::eval(char ch, const_t const & value) const noexcept
 {
+    EXPR_PHASE(eval);
     if ( ! _head ) { return {}; }
     return this->eval_impl(_head, ch, value);
 }
 
-const_t expression::eval_impl(std::shared_ptr<node> const & head) const
+// No character is ever parsed as '\0': every letter has to be a parameter
+void expression::validate() const
+{
+    this->validate_impl(_head, '\0', true);
+}
+
+void expression::validate(char x) const
+{
+    this->validate_impl(_head, x, true);
+}
+
+// With `bound` false, a parameter without value is not an error: it is given at
+// the call of the program
+void expression::validate_impl(std::shared_ptr<node> const & head, char x, bool bound) const
 {
+    if ( ! head ) {
+        throw std::logic_error{"Missing operand"};
+    }
+    std::visit(
+            detail::overload{
+                [ ](const_t const &) {
+                },
+                [&](param_t const & param) {
+                    if ( bound && param != x && _dictionary.find(param) == _dictionary.end() ) {
+                        throw std::logic_error{std::string{"Unassigned parameter "} + param};
+                    }
+                },
+                [&](unary_f const &) {
+                    validate_impl(head->left, x, bound);
+                },
+                [&](binary_f const &) {
+                    validate_impl(head->right, x, bound);
+                    validate_impl(head->left, x, bound);
+                },
+                [ ](nothing) {
+                    throw std::logic_error{"Found (literally) nothing..."};
+                }
+            }, head->content
+    );
+}
+
+// The tree is not validated here: what could go wrong, a missing operand or a
+// parameter without value, gives NaN instead of a throw
+const_t expression::eval_impl(std::shared_ptr<node> const & head) const noexcept
+{
+    if ( ! head ) { return std::numeric_limits<const_t>::quiet_NaN(); }
     return std::visit(
             detail::overload{
                 [ ](const_t const & value) {
                     return value;
                 },
                 [&](param_t const & param) {
-                    //if ( _dictionary.find(param.name) == _dictionary.end() ) {
-                        //throw std::logic_error{std::string{"Unassigned parameter "} + param.name};
-                    //}
-                    //return std::pow(_dictionary.at(param.name), param.exponent) * param.coefficient;
                     auto it = _dictionary.find(param);
-                    if ( it == _dictionary.end() ) {
-                        throw std::logic_error{std::string{"Unassigned parameter "} + param};
-                    }
-                    return it->second;
+                    return it == _dictionary.end() ? std::numeric_limits<const_t>::quiet_NaN() : it->second;
                 },
                 [&](unary_f const & unary) {
                     return unary( eval_impl(head->left) );
@@ -565,35 +638,26 @@ const_t expression::eval_impl(std::shared_ptr<node> const & head) const
                     return binary( eval_impl(head->right), eval_impl(head->left) );
                 },
                 [ ](nothing) {
-                    throw std::logic_error{"Found (literally) nothing..."};
-                    return const_t{0};
+                    return std::numeric_limits<const_t>::quiet_NaN();
                 }
             }, head->content
     );
 }
 
-const_t expression::eval_impl(std::shared_ptr<node> const & head, char x, const_t const & value) const
+const_t expression::eval_impl(std::shared_ptr<node> const & head, char x, const_t const & value) const noexcept
 {
+    if ( ! head ) { return std::numeric_limits<const_t>::quiet_NaN(); }
     return std::visit(
             detail::overload{
                 [ ](const_t const & value) {
                     return value;
                 },
                 [&](param_t const & param) {
-                    //if ( param.name == x ) {
-                        //return std::pow(value, param.exponent) * param.coefficient;
                     if ( param == x ) {
                         return value;
                     }
-                    //if ( _dictionary.find(param.name) == _dictionary.end() ) {
-                    if ( auto it = _dictionary.find(param); it == _dictionary.end() ) {
-                        //throw std::logic_error{std::string{"Unassigned parameter "} + param.name };
-                        throw std::logic_error{std::string{"Unassigned parameter "} + param };
-                    }
-                    //return std::pow(_dictionary.at(param.name), param.exponent) * param.coefficient;
-                    else {
-                        return it->second;
-                    }
+                    auto it = _dictionary.find(param);
+                    return it == _dictionary.end() ? std::numeric_limits<const_t>::quiet_NaN() : it->second;
                 },
                 [&](unary_f const & unary) {
                     return unary( eval_impl(head->left, x, value) );
@@ -602,8 +666,7 @@ const_t expression::eval_impl(std::shared_ptr<node> const & head, char x, const_
                     return binary( eval_impl(head->right, x, value), eval_impl(head->left, x, value) );
                 },
                 [ ](nothing) {
-                    throw std::logic_error{"Found (literally) nothing..."};
-                    return const_t{0};
+                    return std::numeric_limits<const_t>::quiet_NaN();
                 }
             }, head->content
     );
@@ -615,24 +678,411 @@ expression & expression::set_param(char name, const_t const & value)
     return *this;
 }
 
+void expression::eval_parallel(char x, span<const_t const> in, span<const_t> out, executor & pool) const
+{
+    this->eval_parallel(x, in, out, pool, compile_policy{});
+}
+
+// The input is cut in chunks small enough to keep their input and output in the
+// cache of a core, evaluated by the batch kernel of a program compiled only once
+void expression::eval_parallel(
+    char x, span<const_t const> in, span<const_t> out, executor & pool, compile_policy const & p
+) const
+{
+    if ( in.size() != out.size() ) {
+        throw std::invalid_argument{"Input and output of different sizes"};
+    }
+    if ( ! _head || in.empty() ) { return; }
+
+    std::size_t constexpr chunk = 16 * 1024;
+    auto const compiled = *this->compile(x, p);
+    auto const n = (in.size() + chunk - 1) / chunk;
+    pool.run(n, [&](std::size_t i) {
+        auto const first = i * chunk;
+        auto const count = std::min(chunk, in.size() - first);
+        compiled(in.data() + first, out.data() + first, count);
+    });
+}
+
+// Values the variable (or a parameter) is promised to stay within: compiled
+// programs use the cheapest kernels which are still correct in the range
+expression & expression::set_domain(char name, const_t const & lo, const_t const & hi)
+{
+    if ( ! (lo <= hi) ) {
+        throw std::invalid_argument{std::string{"Empty domain for "} + name};
+    }
+    _domains.insert_or_assign(name, interval{lo, hi});
+    return *this;
+}
+
+// Validated once here: the function returned never throws, and evaluates the
+// compiled program without walking the tree nor allocating
 std::optional<std::function<const_t(const_t)>> expression::as_unary(char ch) const &
 {
-    using result_t = std::optional<std::function<const_t(const_t)>>;
-return (_head == nullptr)
-        ? result_t{std::nullopt}
-        : [f=*this,ch](const_t const & x) {
-        return f.eval(ch, x).value();
-    };
+    if ( ! _head ) { return {}; }
+    this->validate(ch);
+    auto code = std::make_shared<program const>(*this->compile(ch));
+    return [code=std::move(code)](const_t const & x) noexcept { return (*code)(x); };
 }
 
 std::optional<std::function<const_t(const_t)>> expression::as_unary(char ch) &&
 {
-    using result_t = std::optional<std::function<const_t(const_t)>>;
-return (_head == nullptr)
-        ? result_t{std::nullopt}
-        : [f=std::move(*this),ch](const_t const & x) {
-        return f.eval(ch, x).value();
-    };
+    return static_cast<expression const &>(*this).as_unary(ch);
+}
+
+namespace detail
+{
+    // The instruction of a function which is not a composition
+    std::optional<opcode> primitive(unary_f const & f) noexcept
+    {
+        if ( holds(f, function::sin)  ) { return opcode::sin;  }
+        if ( holds(f, function::cos)  ) { return opcode::cos;  }
+        if ( holds(f, function::tan)  ) { return opcode::tan;  }
+        if ( holds(f, function::asin) ) { return opcode::asin; }
+        if ( holds(f, function::acos) ) { return opcode::acos; }
+        if ( holds(f, function::atan) ) { return opcode::atan; }
+        if ( holds(f, function::exp)  ) { return opcode::exp;  }
+        if ( holds(f, function::ln)   ) { return opcode::ln;   }
+        if ( holds(f, function::abs)  ) { return opcode::abs;  }
+        if ( holds(f, function::sqrt) ) { return opcode::sqrt; }
+        if ( holds(f, function::cbrt) ) { return opcode::cbrt; }
+        return {};
+    }
+
+    std::optional<opcode> primitive(binary_f const & f) noexcept
+    {
+        if ( holds(f, function::plus)       ) { return opcode::add; }
+        if ( holds(f, function::minus)      ) { return opcode::sub; }
+        if ( holds(f, function::multiplies) ) { return opcode::mul; }
+        if ( holds(f, function::divides)    ) { return opcode::div; }
+        if ( holds(f, function::modulus)    ) { return opcode::mod; }
+        if ( holds(f, function::pow)        ) { return opcode::pow; }
+        return {};
+    }
+
+    std::uint32_t lower(program & p, unary_f const & f, std::uint32_t a)
+    {
+        if ( auto * composed = f.target<unary_of_unary>() ) {
+            return lower(p, composed->f, lower(p, composed->g, a));
+        }
+        if ( auto const op = primitive(f) ) {
+            return p.emit(*op, a);
+        }
+        throw std::logic_error{"Found a function without a correspective instruction"};
+    }
+
+    std::uint32_t lower(program & p, binary_f const & f, std::uint32_t a, std::uint32_t b)
+    {
+        if ( auto * composed = f.target<unary_of_binary>() ) {
+            return lower(p, composed->f, lower(p, composed->g, a, b));
+        }
+        if ( auto * composed = f.target<binary_of_first>() ) {
+            return lower(p, composed->f, lower(p, composed->g, a), b);
+        }
+        if ( auto * composed = f.target<binary_of_second>() ) {
+            return lower(p, composed->f, a, lower(p, composed->g, b));
+        }
+        if ( auto const op = primitive(f) ) {
+            return p.emit(*op, a, b);
+        }
+        throw std::logic_error{"Found an operator without a correspective instruction"};
+    }
+
+    std::size_t size(std::shared_ptr<node> const & head) noexcept
+    {
+        if ( ! head ) { return 0; }
+        auto const binary = std::holds_alternative<binary_f>(head->content);
+        auto const unary  = std::holds_alternative<unary_f>(head->content);
+        return 1 + (binary || unary ? size(head->left) : 0) + (binary ? size(head->right) : 0);
+    }
+
+    // Emit the instructions of the subtree in `head` and return the register of its value
+    std::uint32_t lower(program & p, std::shared_ptr<node> const & head, char x)
+    {
+        if ( ! head ) {
+            throw std::logic_error{"Missing operand"};
+        }
+        return std::visit(
+                overload{
+                    [&](const_t const & value) {
+                        return p.constant(value);
+                    },
+                    [&](param_t const & param) {
+                        return param == x ? p.variable(param) : p.parameter(param);
+                    },
+                    [&](unary_f const & unary) {
+                        return lower(p, unary, lower(p, head->left, x));
+                    },
+                    [&](binary_f const & binary) {
+                        auto const first  = lower(p, head->right, x);
+                        auto const second = lower(p, head->left, x);
+                        return lower(p, binary, first, second);
+                    },
+                    [ ](nothing) -> std::uint32_t {
+                        throw std::logic_error{"Found (literally) nothing..."};
+                    }
+                }, head->content
+        );
+    }
+} // namespace detail
+
+std::optional<program> expression::compile(char x) const
+{
+    return this->compile(x, compile_policy{});
+}
+
+std::optional<program> expression::compile(char x, compile_policy const & p) const
+{
+    return this->compile_impl(x, p, nullptr);
+}
+
+std::optional<program> expression::compile(char x, compile_policy const & p, compile_report & report) const
+{
+    return this->compile_impl(x, p, &report);
+}
+
+std::optional<program> expression::compile_impl(char x, compile_policy const & p, compile_report * report) const
+{
+    EXPR_PHASE(compile);
+    if ( ! _head ) { return {}; }
+    this->validate_impl(_head, x, false);
+
+    auto const start = std::chrono::steady_clock::now();
+    program result;
+    detail::lower(result, _head, x);
+    if ( report ) {
+        auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        report->push_back({ pass::lower, elapsed, detail::size(_head), result.code().size() });
+    }
+    for ( auto const & [name, value] : _dictionary ) {
+        result.bind(name, value);
+    }
+    result.approximate(p.precision).optimize(p, _domains, report);
+    return result;
+}
+
+std::optional<approximation> expression::approximate(char x, const_t lo, const_t hi, const_t tolerance) const
+{
+    if ( ! _head ) { return {}; }
+    this->validate(x);
+    return approximation::fit(
+        [this,x](const_t const & value) { return this->eval_impl(_head, x, value); },
+        lo, hi, tolerance
+    );
+}
+
+namespace detail
+{
+    // The operators as they are written, the functions by their name
+    std::string symbol(opcode op)
+    {
+        switch (op) {
+            case opcode::add: return "+";
+            case opcode::sub: return "-";
+            case opcode::mul: return "*";
+            case opcode::div: return "/";
+            case opcode::mod: return "%";
+            case opcode::pow: return "^";
+            default:          return mnemonic(op);
+        }
+    }
+
+    // A composition shows as its functions joined by °, a function of one of the
+    // operands of a binary one with _ in place of the other operand
+    std::string describe(unary_f const & f)
+    {
+        if ( auto * composed = f.target<unary_of_unary>() ) {
+            return describe(composed->f) + "°" + describe(composed->g);
+        }
+        auto const op = primitive(f);
+        return op ? symbol(*op) : "?";
+    }
+
+    std::string describe(binary_f const & f)
+    {
+        if ( auto * composed = f.target<unary_of_binary>() ) {
+            return describe(composed->f) + "°" + describe(composed->g);
+        }
+        if ( auto * composed = f.target<binary_of_first>() ) {
+            return describe(composed->f) + " (" + describe(composed->g) + " _) _";
+        }
+        if ( auto * composed = f.target<binary_of_second>() ) {
+            return describe(composed->f) + " _ (" + describe(composed->g) + " _)";
+        }
+        auto const op = primitive(f);
+        return op ? symbol(*op) : "?";
+    }
+
+    bool composed(binary_f const & f) noexcept
+    {
+        return ! primitive(f);
+    }
+
+    bool composed(unary_f const & f) noexcept
+    {
+        return ! primitive(f);
+    }
+
+    // Of the function alone, as the sum of the instructions it is lowered to
+    double cost(unary_f const & f) noexcept
+    {
+        if ( auto * composed = f.target<unary_of_unary>() ) {
+            return cost(composed->f) + cost(composed->g);
+        }
+        auto const op = primitive(f);
+        return op ? cost(*op) : 0;
+    }
+
+    double cost(binary_f const & f) noexcept
+    {
+        if ( auto * composed = f.target<unary_of_binary>() ) {
+            return cost(composed->f) + cost(composed->g);
+        }
+        if ( auto * composed = f.target<binary_of_first>() ) {
+            return cost(composed->f) + cost(composed->g);
+        }
+        if ( auto * composed = f.target<binary_of_second>() ) {
+            return cost(composed->f) + cost(composed->g);
+        }
+        auto const op = primitive(f);
+        return op ? cost(*op) : 0;
+    }
+
+    double cost(node const & n) noexcept
+    {
+        return std::visit(
+                overload{
+                    [ ](unary_f const & f)  { return cost(f); },
+                    [ ](binary_f const & f) { return cost(f); },
+                    [ ](auto const &)       { return 0.0; }
+                }, n.content
+        );
+    }
+
+    // The operands of a node: none for the leaves, whatever optimize() left below them
+    bool unary(node const & n) noexcept  { return std::holds_alternative<unary_f>(n.content); }
+    bool binary(node const & n) noexcept { return std::holds_alternative<binary_f>(n.content); }
+
+    double subtree_cost(std::shared_ptr<node> const & head) noexcept
+    {
+        if ( ! head ) { return 0; }
+        auto result = cost(*head);
+        if ( unary(*head) || binary(*head) ) { result += subtree_cost(head->left); }
+        if ( binary(*head) )                 { result += subtree_cost(head->right); }
+        return result;
+    }
+
+    std::string label(node const & n)
+    {
+        return std::visit(
+                overload{
+                    [ ](const_t const & value) { return format(value); },
+                    [ ](param_t const & param) { return std::string(1, param); },
+                    [ ](unary_f const & f)  { return composed(f) ? "[" + describe(f) + "]" : describe(f); },
+                    [ ](binary_f const & f) { return composed(f) ? "[" + describe(f) + "]" : describe(f); },
+                    [ ](nothing) { return std::string{"nothing"}; }
+                }, n.content
+        );
+    }
+
+    // (+ 6 ([*5] x)): the first operand of a binary function is the right child
+    std::string print(std::shared_ptr<node> const & head)
+    {
+        if ( ! head ) { return "<missing>"; }
+        return std::visit(
+                overload{
+                    [&](unary_f const &) { return "(" + label(*head) + " " + print(head->left) + ")"; },
+                    [&](binary_f const &) {
+                        return "(" + label(*head) + " " + print(head->right) + " " + print(head->left) + ")";
+                    },
+                    [&](auto const &) { return label(*head); }
+                }, head->content
+        );
+    }
+
+    // One node per line, indented by depth, after its cost and the cost of its subtree
+    void outline(std::shared_ptr<node> const & head, std::size_t depth, std::string & out)
+    {
+        if ( ! head ) { return; }
+        auto const column = [](double value, std::size_t width) {
+            auto text = format(value);
+            return std::string(text.size() < width ? width - text.size() : 1, ' ') + text;
+        };
+        out += column(subtree_cost(head), 10) + column(cost(*head), 8) + "  " + std::string(2 * depth, ' ') + label(*head) + '\n';
+        if ( binary(*head) ) {
+            outline(head->right, depth + 1, out);
+        }
+        if ( unary(*head) || binary(*head) ) {
+            outline(head->left, depth + 1, out);
+        }
+    }
+
+    // optimize() changes the nodes in place, and copies of an expression share them
+    std::shared_ptr<node> clone(std::shared_ptr<node> const & head)
+    {
+        if ( ! head ) { return nullptr; }
+        auto result = std::make_shared<node>(head->content);
+        result->left  = clone(head->left);
+        result->right = clone(head->right);
+        return result;
+    }
+} // namespace detail
+
+std::size_t expression::size() const noexcept
+{
+    return detail::size(_head);
+}
+
+double expression::cost() const noexcept
+{
+    return detail::subtree_cost(_head);
+}
+
+std::string expression::explain(char x) const
+{
+    return this->explain(x, compile_policy{});
+}
+
+// The tree as it is, the tree after optimize() (on a copy) and the program
+// compile(x, p) would give, each one with its estimated cost
+std::string expression::explain(char x, compile_policy const & p) const
+{
+    if ( ! _head ) { return "empty expression\n"; }
+
+    auto const before = detail::print(_head);
+    auto optimized = *this;
+    optimized._head = detail::clone(_head);
+    optimized.optimize();
+    auto const after = detail::print(optimized._head);
+
+    std::string result;
+    result += "tree (cost " + format(detail::subtree_cost(_head)) + "):\n  " + before + "\n";
+    if ( after == before ) {
+        result += "optimize() changes nothing\n";
+    }
+    else {
+        result += "optimized (cost " + format(detail::subtree_cost(optimized._head)) + "):\n  " + after + "\n";
+    }
+    result += "      cost    self  node\n";
+    detail::outline(optimized._head, 0, result);
+
+    compile_report report;
+    auto const code = *this->compile(x, p, report);
+    result += "passes:\n";
+    for ( auto const & r : report ) {
+        char line[96];
+        std::snprintf(line, sizeof(line), "  %-10s %9.1f us %6zu -> %zu\n", pass_name(r.which), r.seconds * 1e6, r.before, r.after);
+        result += line;
+    }
+    result += "program for " + std::string(1, x) + " (" + std::to_string(code.code().size())
+        + " instructions, cost " + format(expr::cost(code)) + "):\n";
+    auto const lines = listing(code);
+    for ( std::size_t first = 0; first < lines.size(); ) {
+        auto const last = lines.find('\n', first);
+        result += "  " + lines.substr(first, last + 1 - first);
+        first = last + 1;
+    }
+    return result;
 }
 
 } // namespace expr
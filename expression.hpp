@@ -10,8 +10,14 @@
 
 #include <map>
 #include <memory>
+#include <cstddef>
+#include <string>
+#include <vector>
 #include <variant>
+#include <optional>
+#include <type_traits>
 #include <functional>
+#include <string_view>
 
 namespace expr
 {
@@ -31,6 +37,38 @@ using param_t  = char;
 
 using variant_t = std::variant<nothing, const_t, param_t, unary_f, binary_f>;
 
+struct interval
+{
+    const_t lo;
+    const_t hi;
+};
+
+// A view over contiguous values, in place of the C++20 std::span
+template <typename T>
+class span
+{
+    T * _data = nullptr;
+    std::size_t _size = 0;
+public:
+    constexpr span() noexcept = default;
+    constexpr span(T * data, std::size_t size) noexcept : _data{data}, _size{size} {}
+    template <std::size_t N>
+    constexpr span(T (&array)[N]) noexcept : _data{array}, _size{N} {}
+    template <
+        typename Container,
+        typename = std::enable_if_t<std::is_convertible_v<decltype(std::declval<Container &>().data()), T *>>
+    >
+    constexpr span(Container & c) noexcept : _data{c.data()}, _size{c.size()} {}
+
+    constexpr T * data()  const noexcept { return _data; }
+    constexpr T * begin() const noexcept { return _data; }
+    constexpr T * end()   const noexcept { return _data + _size; }
+    constexpr std::size_t size() const noexcept { return _size; }
+    constexpr bool empty()       const noexcept { return _size == 0; }
+    constexpr T & operator[](std::size_t i) const noexcept { return _data[i]; }
+    constexpr span subspan(std::size_t offset, std::size_t count) const noexcept { return {_data + offset, count}; }
+};
+
 struct node
 {
     template <
@@ -48,10 +86,20 @@ struct node
     std::shared_ptr<node> right;
 };
 
+class program;
+class executor;
+class approximation;
+struct compile_policy;
+struct pass_record;
+using compile_report = std::vector<pass_record>;
+
 class expression
 {
+    friend struct benchmark_access;    // times the private phases
+
     std::shared_ptr<node> _head;
     std::map<char, const_t> _dictionary;
+    std::map<char, interval> _domains;
 
 public:
     enum class policy { build, optimize, };
@@ -66,13 +114,41 @@ public:
     expression & build(policy p, std::string const & src);
     expression & build(policy p, std::string && src);
     expression & optimize();
-    std::optional<const_t> eval() const;
-    std::optional<const_t> eval(char x, const_t const & value) const;
+    // Empty only for an expression without a tree (e.g. moved from): every other
+    // failure is a NaN in the value
+    std::optional<const_t> eval() const noexcept;
+    std::optional<const_t> eval(char x, const_t const & value) const noexcept;
+    void eval_parallel(char x, span<const_t const> in, span<const_t> out, executor & pool) const;
+    void eval_parallel(char x, span<const_t const> in, span<const_t> out, executor & pool, compile_policy const & p) const;
+
+    // Throw std::logic_error if the expression cannot be evaluated (a missing
+    // operand, a parameter without value); as_unary() checks this once. eval()
+    // does not check, and gives NaN where an operand or a value is missing
+    void validate() const;
+    void validate(char x) const;
 
     expression & set_param(char name, const_t const & value);
+    expression & set_domain(char name, const_t const & lo, const_t const & hi);
 
     std::optional<std::function<const_t(const_t)>> as_unary(char x = 'x') const &;
     std::optional<std::function<const_t(const_t)>> as_unary(char x = 'x') &&;
+    // Throw std::logic_error for a missing operand; the parameters without value
+    // are given when the program is called
+    std::optional<program> compile(char x = 'x') const;
+    std::optional<program> compile(char x, compile_policy const & p) const;
+    // With the time each pass took and the instructions it removed
+    std::optional<program> compile(char x, compile_policy const & p, compile_report & report) const;
+    std::optional<approximation> approximate(char x, const_t lo, const_t hi, const_t tolerance) const;
+
+    // A report of the tree, of what optimize() would make of it and of the
+    // compiled program, with the estimated cost of every node and instruction
+    std::string explain(char x = 'x') const;
+    std::string explain(char x, compile_policy const & p) const;
+
+    // The nodes of the tree, and the static estimate of one evaluation of it
+    // (the sum of the cost of its operations, see cost(opcode))
+    std::size_t size() const noexcept;
+    double cost() const noexcept;
     explicit operator bool() const { return _head != nullptr; }
 private:
     std::vector<variant_t> parse(std::string && src);
@@ -81,53 +157,22 @@ private:
     expression & build_impl(std::string const & src);
     expression & build_impl(std::string && src);
     void optimize_impl(std::shared_ptr<node> & head);
-    const_t eval_impl(std::shared_ptr<node> const & head) const;
-    const_t eval_impl(std::shared_ptr<node> const & head, char x, const_t const & value) const;
+    void validate_impl(std::shared_ptr<node> const & head, char x, bool bound) const;
+    const_t eval_impl(std::shared_ptr<node> const & head) const noexcept;
+    const_t eval_impl(std::shared_ptr<node> const & head, char x, const_t const & value) const noexcept;
+    std::optional<program> compile_impl(char x, compile_policy const & p, compile_report * report) const;
 
 };
 
-inline auto compute(std::string const & source)
-    -> std::optional<const_t>
-{
-    expression expr{source};
-    return expr.eval();
-}
-
-inline auto compute(std::string && source)
-    -> std::optional<const_t>
-{
-    expression expr{std::move(source)};
-    return expr.eval();
-}
-
-inline auto compute(std::string const & source, char x, const_t const & value)
-    -> std::optional<const_t>
-{
-    expression expr{source};
-    return expr.eval(x, value);
-}
-
-inline auto compute(std::string && source, char x, const_t const & value)
-    -> std::optional<const_t>
-{
-    expression expr{std::move(source)};
-    return expr.eval(x, value);
-}
-inline auto parse_function( std::string const & source, char x, expression::policy p)
-    -> std::optional<std::function<const_t(const_t)>>
-{
-    expression expr{p, source};
-    return std::move(expr).as_unary(x);
-}
-
-inline auto parse_function( std::string &&   source, char x, expression::policy p)
-    -> std::optional<std::function<const_t(const_t)>>
-{
-    expression expr{p, std::move(source)};
-    return std::move(expr).as_unary(x);
-}
-
-
+// Through program_cache::global(): the same source is parsed and compiled once
+auto compute(std::string const & source) -> std::optional<const_t>;
+auto compute(std::string && source) -> std::optional<const_t>;
+auto compute(std::string const & source, char x, const_t const & value) -> std::optional<const_t>;
+auto compute(std::string && source, char x, const_t const & value) -> std::optional<const_t>;
+auto parse_function(std::string const & source, char x, expression::policy p)
+    -> std::optional<std::function<const_t(const_t)>>;
+auto parse_function(std::string && source, char x, expression::policy p)
+    -> std::optional<std::function<const_t(const_t)>>;
 
 } // namespace expr
 
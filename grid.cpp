@@ -0,0 +1,168 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : grid
+ * @created     : Friday October 16, 2026 23:09:51 CEST
+ * @license     : MIT
+ * */
+
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+#include "grid.hpp"
+#include "executor.hpp"
+
+
+namespace expr
+{
+
+namespace detail
+{
+    // A tile is the input and the output of a row in the cache of a core, for
+    // the few rows which share them
+    std::size_t constexpr tile_values = 512;
+    std::size_t constexpr tile_rows   = 16;
+
+    std::size_t points(span<axis const> axes) noexcept
+    {
+        std::size_t result = 1;
+        for ( auto const & a : axes ) { result *= a.points; }
+        return result;
+    }
+
+    // The slot in the parameters of each axis but the first, npos for a letter
+    // `f` does not use
+    std::array<std::size_t, 3> slots(compiled_expression const & f, span<axis const> axes)
+    {
+        if ( axes.empty() || axes.size() > 3 ) {
+            throw std::invalid_argument{"A grid has one to three axes"};
+        }
+        auto const & variables = f.code().variables();
+        std::array<std::size_t, 3> result;
+        result.fill(compiled_expression::npos);
+        for ( std::size_t d = 0; d < axes.size(); ++d ) {
+            auto const name = axes[d].name;
+            for ( std::size_t e = 0; e < d; ++e ) {
+                if ( axes[e].name == name ) {
+                    throw std::invalid_argument{std::string{"Two axes for "} + name};
+                }
+            }
+            auto const slot = f.slot(name);
+            if ( d == 0 && slot != compiled_expression::npos ) {
+                throw std::invalid_argument{std::string{"The first axis is a parameter: "} + name};
+            }
+            if ( d == 0 && ! variables.empty() && std::find(variables.begin(), variables.end(), name) == variables.end() ) {
+                throw std::invalid_argument{std::string{"The first axis is not the variable: "} + name};
+            }
+            if ( d > 0 && std::find(variables.begin(), variables.end(), name) != variables.end() ) {
+                throw std::invalid_argument{std::string{"Only the first axis can be the variable: "} + name};
+            }
+            result[d] = d == 0 ? compiled_expression::npos : slot;
+        }
+        return result;
+    }
+} // namespace detail
+
+const_t axis::operator[](std::size_t i) const noexcept
+{
+    if ( points <= 1 ) {
+        return first;
+    }
+    if ( i + 1 == points ) {
+        return last;
+    }
+    return first + (last - first) * static_cast<const_t>(i) / static_cast<const_t>(points - 1);
+}
+
+grid_output grid_output::row_major(const_t * data, span<axis const> axes) noexcept
+{
+    grid_output result{ data, {} };
+    std::ptrdiff_t stride = 1;
+    for ( std::size_t d = 0; d < axes.size() && d < 3; ++d ) {
+        result.strides[d] = stride;
+        stride *= static_cast<std::ptrdiff_t>(axes[d].points);
+    }
+    return result;
+}
+
+// A row is a run of values along the first axis, with the others fixed: the
+// batch kernel computes what depends only on them once per row of a tile
+void eval_grid(compiled_expression const & f, span<axis const> axes, grid_output out, executor & pool)
+{
+    auto const slots = detail::slots(f, axes);
+    if ( detail::points(axes) == 0 ) {
+        return;
+    }
+    auto const axis_at = [&](std::size_t d) { return d < axes.size() ? axes[d] : axis{ '\0' }; };
+    auto const x = axis_at(0);
+    auto const y = axis_at(1);
+    auto const z = axis_at(2);
+
+    std::vector<const_t> xs(x.points);
+    for ( std::size_t i = 0; i < xs.size(); ++i ) { xs[i] = x[i]; }
+
+    auto const rows = y.points * z.points;
+    auto const across = (x.points + detail::tile_values - 1) / detail::tile_values;
+    auto const down   = (rows + detail::tile_rows - 1) / detail::tile_rows;
+    auto const & bound = f.code().bindings();
+
+    pool.run(across * down, [&](std::size_t tile) {
+        auto const first = tile % across * detail::tile_values;
+        auto const count = std::min(detail::tile_values, x.points - first);
+        auto const top   = tile / across * detail::tile_rows;
+        auto const last  = std::min(rows, top + detail::tile_rows);
+
+        std::vector<const_t> params(bound.begin(), bound.end());
+        std::vector<const_t> buffer(out.strides[0] == 1 ? 0 : count);
+        workspace registers{ f.code().view() };
+        for ( auto row = top; row < last; ++row ) {
+            auto const j = row % y.points;
+            auto const k = row / y.points;
+            if ( slots[1] != compiled_expression::npos ) { params[slots[1]] = y[j]; }
+            if ( slots[2] != compiled_expression::npos ) { params[slots[2]] = z[k]; }
+
+            auto * start = out.data + static_cast<std::ptrdiff_t>(first) * out.strides[0]
+                         + static_cast<std::ptrdiff_t>(j) * out.strides[1]
+                         + static_cast<std::ptrdiff_t>(k) * out.strides[2];
+            if ( buffer.empty() ) {
+                f({ xs.data() + first, count }, { start, count }, params, registers);
+                continue;
+            }
+            f({ xs.data() + first, count }, buffer, params, registers);
+            for ( std::size_t i = 0; i < count; ++i ) {
+                start[static_cast<std::ptrdiff_t>(i) * out.strides[0]] = buffer[i];
+            }
+        }
+    });
+}
+
+void eval_grid(compiled_expression const & f, span<axis const> axes, span<const_t> out, executor & pool)
+{
+    detail::slots(f, axes);
+    if ( out.size() != detail::points(axes) ) {
+        throw std::invalid_argument{"Output of a size different from the grid"};
+    }
+    eval_grid(f, axes, grid_output::row_major(out.data(), axes), pool);
+}
+
+void eval_grid(compiled_expression const & f, span<axis const> axes, span<const_t> out)
+{
+    executor pool;
+    eval_grid(f, axes, out, pool);
+}
+
+void eval_grid(
+    expression const & f, span<axis const> axes, span<const_t> out, executor & pool, compile_policy const & p
+)
+{
+    if ( axes.empty() ) {
+        throw std::invalid_argument{"A grid has one to three axes"};
+    }
+    auto code = f.compile(axes[0].name, p);
+    if ( ! code ) {
+        throw std::invalid_argument{"Empty expression"};
+    }
+    eval_grid(compiled_expression{std::move(*code)}, axes, out, pool);
+}
+
+} // namespace expr
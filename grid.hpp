@@ -0,0 +1,65 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : grid
+ * @created     : Friday October 16, 2026 23:02:18 CEST
+ * @license     : MIT
+ * */
+
+#ifndef GRID_HPP
+#define GRID_HPP
+
+#include <array>
+#include <cstddef>
+#include "expression.hpp"
+#include "program.hpp"
+#include "compiled_expression.hpp"
+
+namespace expr
+{
+
+class executor;
+
+// `points` values of the letter `name`, evenly spaced from `first` to `last`,
+// both included
+struct axis
+{
+    char name;
+    const_t first = 0;
+    const_t last = 0;
+    std::size_t points = 1;
+
+    const_t operator[](std::size_t i) const noexcept;
+};
+
+// Where the value at the point (i, j, k) of a grid goes, i along the first axis:
+// data[i * strides[0] + j * strides[1] + k * strides[2]]. The strides count
+// values and can be negative, e.g. for an image with y growing upwards
+struct grid_output
+{
+    const_t * data = nullptr;
+    std::array<std::ptrdiff_t, 3> strides = {};
+
+    // The first axis contiguous, then the second: data[(k * ny + j) * nx + i]
+    static grid_output row_major(const_t * data, span<axis const> axes) noexcept;
+};
+
+// The values of `f` over the grid of one to three axes. The first axis is the
+// variable, the others are parameters of `f`, or letters it does not use; the
+// parameters on no axis keep their bound value. The grid is cut in tiles of a
+// few rows by a few hundred values, spread over the threads of `pool`, each
+// tile evaluated one row at a time by the batch kernel. Throws
+// std::invalid_argument for an axis which is not one of those, or an output
+// of the wrong size
+void eval_grid(compiled_expression const & f, span<axis const> axes, grid_output out, executor & pool);
+void eval_grid(compiled_expression const & f, span<axis const> axes, span<const_t> out, executor & pool);
+void eval_grid(compiled_expression const & f, span<axis const> axes, span<const_t> out);
+
+// Compiled for the letter of the first axis; throws std::invalid_argument for an
+// empty expression, std::logic_error as compile() does
+void eval_grid(
+    expression const & f, span<axis const> axes, span<const_t> out, executor & pool, compile_policy const & p = {}
+);
+
+} // namespace expr
+
+#endif /* GRID_HPP */
@@ -0,0 +1,258 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : live_expression
+ * @created     : Friday October 16, 2026 15:53:12 CEST
+ * @license     : MIT
+ * */
+
+#include <new>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <algorithm>
+#include "live_expression.hpp"
+
+
+namespace expr
+{
+
+namespace detail
+{
+    // A pointer a reader is using: writers do not free what is published here.
+    // Records are never deleted, only released when their thread exits
+    struct hazard
+    {
+        std::atomic<void const *> pointer{nullptr};
+        std::atomic<bool> used{false};
+        hazard * next = nullptr;
+    };
+
+    // The records of the first threads are in a fixed table; those past it come
+    // from the heap once, and are reused as the others
+    std::size_t constexpr table_size = 128;
+    hazard table[table_size];
+    std::atomic<hazard *> overflow{nullptr};
+
+    inline bool take(hazard & h) noexcept
+    {
+        bool free = false;
+        return ! h.used.load(std::memory_order_relaxed) && h.used.compare_exchange_strong(free, true);
+    }
+
+    hazard * acquire_hazard() noexcept
+    {
+        while ( true ) {
+            for ( auto & h : table ) {
+                if ( take(h) ) { return &h; }
+            }
+            for ( auto * h = overflow.load(); h != nullptr; h = h->next ) {
+                if ( take(*h) ) { return h; }
+            }
+            if ( auto * h = new (std::nothrow) hazard ) {
+                h->used.store(true);
+                h->next = overflow.load();
+                while ( ! overflow.compare_exchange_weak(h->next, h) ) { ; }
+                return h;
+            }
+            std::this_thread::yield();      // out of memory: wait for a thread to exit
+        }
+    }
+
+    bool in_use(void const * p) noexcept
+    {
+        for ( auto const & h : table ) {
+            if ( h.pointer.load() == p ) { return true; }
+        }
+        for ( auto * h = overflow.load(); h != nullptr; h = h->next ) {
+            if ( h->pointer.load() == p ) { return true; }
+        }
+        return false;
+    }
+
+    struct hazard_owner
+    {
+        hazard * record = acquire_hazard();
+        ~hazard_owner()
+        {
+            record->pointer.store(nullptr);
+            record->used.store(false);
+        }
+    };
+
+    inline hazard & my_hazard()
+    {
+        thread_local hazard_owner owner;
+        return *owner.record;
+    }
+
+    // Load `source` and publish it as in use; the loop ends when the value did not
+    // change in between, so a writer scanning after its swap will see it
+    template <typename T>
+    inline T * protect(std::atomic<T *> const & source, hazard & h) noexcept
+    {
+        T * value = source.load();
+        while ( true ) {
+            h.pointer.store(value);
+            T * const check = source.load();
+            if ( check == value ) {
+                return value;
+            }
+            value = check;
+        }
+    }
+
+} // namespace detail
+
+// Keeps the current version from being freed while it is read. On the way out, a
+// reader which finds its version replaced tries to free it, as it may have been
+// the last one using it
+class live_expression::reader
+{
+    live_expression const & _owner;
+    detail::hazard & _hazard;
+    version * _seen;
+public:
+    explicit reader(live_expression const & owner) noexcept :
+        _owner{owner}, _hazard{detail::my_hazard()}, _seen{detail::protect(owner._current, _hazard)}
+    { ; }
+    ~reader()
+    {
+        _hazard.pointer.store(nullptr);
+        if ( _owner._current.load() != _seen ) {
+            _owner._stale.store(true);
+            _owner.collect();
+        }
+    }
+    version const * operator->() const noexcept { return _seen; }
+};
+
+live_expression::live_expression(expression source, char x) :
+    live_expression{ std::move(source), x, compile_policy{} }
+{ ; }
+
+live_expression::live_expression(expression source, char x, compile_policy const & p) :
+    _current{nullptr}, _stale{false}, _source{std::move(source)}, _variable{x}, _policy{p}
+{
+    _current.store(new version{ std::make_shared<program const>(*_source.compile(_variable, _policy)) });
+}
+
+live_expression::~live_expression()
+{
+    delete _current.load();
+    for ( auto * v : _retired ) {
+        delete v;
+    }
+}
+
+compiled_expression live_expression::snapshot() const noexcept
+{
+    reader current{*this};
+    return compiled_expression{ current->code };
+}
+
+const_t live_expression::operator()(const_t const & x) const noexcept
+{
+    reader current{*this};
+    return (*current->code)(x);
+}
+
+void live_expression::operator()(span<const_t const> in, span<const_t> out) const noexcept
+{
+    reader current{*this};
+    (*current->code)(in.data(), out.data(), std::min(in.size(), out.size()));
+}
+
+// The writers build everything which can throw first, the next source included;
+// from the exchange on nothing throws, so a failure leaves the old version and
+// its source in place
+static_assert(std::is_nothrow_move_assignable_v<expression>);
+
+live_expression & live_expression::set_param(char name, const_t const & value)
+{
+    {
+        std::lock_guard lock{_writer};
+        auto code = std::make_shared<program>(*_current.load()->code);
+        code->bind(name, value);
+        auto source = _source;
+        source.set_param(name, value);
+        this->swap(this->prepare(std::move(code)));
+        _source = std::move(source);
+    }
+    this->collect();
+    return *this;
+}
+
+live_expression & live_expression::build(std::string const & source)
+{
+    {
+        std::lock_guard lock{_writer};
+        auto next = _source;
+        next.build(source);
+        auto fresh = this->prepare(std::make_shared<program const>(*next.compile(_variable, _policy)));
+        this->swap(std::move(fresh));
+        _source = std::move(next);
+    }
+    this->collect();
+    return *this;
+}
+
+live_expression & live_expression::publish(compiled_expression next)
+{
+    {
+        std::lock_guard lock{_writer};
+        this->swap(this->prepare(next.share()));
+    }
+    this->collect();
+    return *this;
+}
+
+std::size_t live_expression::retired()
+{
+    std::size_t result;
+    {
+        std::lock_guard lock{_writer};
+        this->reclaim();
+        result = _retired.size();
+    }
+    this->collect();
+    return result;
+}
+
+// Called with the writer lock held: the version, and room to retire the current one
+auto live_expression::prepare(std::shared_ptr<program const> next)
+    -> std::unique_ptr<version>
+{
+    auto fresh = std::make_unique<version>(version{ std::move(next) });
+    _retired.reserve(_retired.size() + 1);
+    return fresh;
+}
+
+// Called with the writer lock held, after prepare()
+void live_expression::swap(std::unique_ptr<version> fresh) noexcept
+{
+    _retired.push_back(_current.exchange(fresh.release()));
+    this->reclaim();
+}
+
+// Whoever holds the lock when a reader leaves a replaced version frees it after
+// letting the lock go: the reader only tries to take it, and never waits
+void live_expression::collect() const noexcept
+{
+    while ( _stale.load() && _writer.try_lock() ) {
+        _stale.store(false);
+        this->reclaim();
+        _writer.unlock();
+    }
+}
+
+// Called with the writer lock held; neither allocates nor throws, as readers
+// call it too
+void live_expression::reclaim() const noexcept
+{
+    auto const in_use = [](version * v) { return detail::in_use(v); };
+    auto const end = std::partition(_retired.begin(), _retired.end(), in_use);
+    std::for_each(end, _retired.end(), [](version * v) { delete v; });
+    _retired.erase(end, _retired.end());
+}
+
+} // namespace expr
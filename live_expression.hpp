@@ -0,0 +1,75 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : live_expression
+ * @created     : Friday October 16, 2026 15:48:30 CEST
+ * @license     : MIT
+ * */
+
+#ifndef LIVE_EXPRESSION_HPP
+#define LIVE_EXPRESSION_HPP
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include "expression.hpp"
+#include "program.hpp"
+#include "compiled_expression.hpp"
+
+namespace expr
+{
+
+// An expression which can be changed while other threads are evaluating it.
+// Writers build the new version off to the side and swap it in with a single
+// atomic store; readers never wait nor take a lock, and keep using the version
+// they started with. A replaced version is freed as soon as its last reader is
+// gone, by that reader or by the next writer (hazard pointers), its program when
+// the last snapshot holding it is destroyed
+class live_expression
+{
+    struct version
+    {
+        std::shared_ptr<program const> code;
+    };
+
+    class reader;
+
+    std::atomic<version *> _current;
+    mutable std::mutex _writer;         // writers, and readers freeing what they leave
+    mutable std::atomic<bool> _stale;   // a reader left a replaced version
+    expression _source;
+    char _variable;
+    compile_policy _policy;
+    mutable std::vector<version *> _retired;
+
+public:
+    explicit live_expression(expression source, char x = 'x');
+    live_expression(expression source, char x, compile_policy const & p);
+    ~live_expression();
+    live_expression(live_expression const &) = delete;
+    live_expression & operator=(live_expression const &) = delete;
+
+    // Readers
+    compiled_expression snapshot() const noexcept;
+    const_t operator()(const_t const & x) const noexcept;
+    void operator()(span<const_t const> in, span<const_t> out) const noexcept;
+
+    // Writers: if anything throws (parsing, compiling, allocating), the current
+    // version and its source stay in place
+    live_expression & set_param(char name, const_t const & value);
+    live_expression & build(std::string const & source);
+    live_expression & publish(compiled_expression next);
+
+    // Replaced versions still waiting for a reader to leave
+    std::size_t retired();
+private:
+    auto prepare(std::shared_ptr<program const> next) -> std::unique_ptr<version>;
+    void swap(std::unique_ptr<version> fresh) noexcept;
+    void collect() const noexcept;
+    void reclaim() const noexcept;
+};
+
+} // namespace expr
+
+#endif /* LIVE_EXPRESSION_HPP */
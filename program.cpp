@@ -0,0 +1,1246 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : program
+ * @created     : Friday October 16, 2026 10:14:02 CEST
+ * @license     : MIT
+ * */
+
+#include <map>
+#include <cmath>
+#include <tuple>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <algorithm>
+#include "program.hpp"
+#include "allocation_counter.hpp"
+
+
+namespace expr
+{
+
+namespace detail
+{
+    // The domain of the kernels chosen after a range analysis
+    inline bool anywhere(const_t) noexcept { return true; }
+
+    // libm, or the approximation where it is valid
+    template <accuracy A, typename Approx, typename Exact, typename Domain>
+    inline const_t approximate(const_t x, Approx f, Exact g, Domain domain) noexcept
+    {
+        if constexpr ( A == accuracy::exact ) {
+            return g(x);
+        }
+        else {
+            return domain(x) ? f(x) : g(x);
+        }
+    }
+
+    template <accuracy A>
+    inline const_t apply(opcode op, const_t a, const_t b, const_t c) noexcept
+    {
+        using T = const_t;
+        switch (op) {
+            case opcode::add:  return a + b;
+            case opcode::sub:  return a - b;
+            case opcode::mul:  return a * b;
+            case opcode::div:  return a / b;
+            case opcode::mod:  return modulus(a, b);
+            case opcode::pow:  return std::pow(a, b);
+            case opcode::sin:  return approximate<A>(a, approx::sin<A>, [](T x) { return std::sin(x); }, approx::trig::domain);
+            case opcode::cos:  return approximate<A>(a, approx::cos<A>, [](T x) { return std::cos(x); }, approx::trig::domain);
+            case opcode::tan:  return approximate<A>(a, approx::tan<A>, [](T x) { return std::tan(x); }, approx::trig::domain);
+            case opcode::asin: return std::asin(a);
+            case opcode::acos: return std::acos(a);
+            case opcode::atan: return approximate<A>(a, approx::atan<A>, [](T x) { return std::atan(x); }, approx::arctangent::domain);
+            case opcode::exp:  return approximate<A>(a, approx::exp<A>, [](T x) { return std::exp(x); }, approx::exponential::domain);
+            case opcode::ln:   return approximate<A>(a, approx::ln<A>, [](T x) { return std::log(x); }, approx::logarithm::domain);
+            case opcode::abs:  return std::abs(a);
+            case opcode::sqrt: return approximate<A>(a, approx::sqrt<A>, [](T x) { return std::sqrt(x); }, approx::square_root::domain);
+            case opcode::cbrt: return std::cbrt(a);
+            case opcode::sin_small:   return approximate<A>(a, approx::sin_small<A>, [](T x) { return std::sin(x); }, anywhere);
+            case opcode::cos_small:   return approximate<A>(a, approx::cos_small<A>, [](T x) { return std::cos(x); }, anywhere);
+            case opcode::tan_small:   return approximate<A>(a, approx::tan_small<A>, [](T x) { return std::tan(x); }, anywhere);
+            case opcode::ln_normal:   return approximate<A>(a, approx::ln<A>, [](T x) { return std::log(x); }, anywhere);
+            case opcode::sqrt_finite: return approximate<A>(a, approx::sqrt<A>, [](T x) { return std::sqrt(x); }, anywhere);
+            case opcode::fma:  return std::fma(a, b, c);
+            case opcode::fms:  return std::fma(a, b, -c);
+            case opcode::fnma: return std::fma(-a, b, c);
+            default:           return std::numeric_limits<const_t>::quiet_NaN();
+        }
+    }
+
+    template <accuracy A>
+    inline void sincos(const_t a, const_t & s, const_t & c) noexcept
+    {
+        if constexpr ( A != accuracy::exact ) {
+            if ( approx::trig::domain(a) ) {
+                return approx::sincos<A>(a, s, c);
+            }
+        }
+#if defined(__GLIBC__)
+        ::sincos(a, &s, &c);
+#else
+        s = std::sin(a);
+        c = std::cos(a);
+#endif
+    }
+
+    // The loops below are kept free of calls other than the operation itself, so
+    // that the compiler can vectorize them
+    template <typename F>
+    inline void map(const_t * dst, const_t const * a, std::size_t n, F f)
+    {
+        for ( std::size_t i = 0; i < n; ++i ) { dst[i] = f(a[i]); }
+    }
+
+    template <typename F>
+    inline void map(const_t * dst, const_t const * a, const_t const * b, std::size_t n, F f)
+    {
+        for ( std::size_t i = 0; i < n; ++i ) { dst[i] = f(a[i], b[i]); }
+    }
+
+    template <typename F>
+    inline void map(const_t * dst, const_t const * a, const_t const * b, const_t const * c, std::size_t n, F f)
+    {
+        for ( std::size_t i = 0; i < n; ++i ) { dst[i] = f(a[i], b[i], c[i]); }
+    }
+
+    // The approximation on the whole block, then libm on the few elements out of its domain
+    template <accuracy A, typename Approx, typename Exact, typename Domain>
+    inline void approximate(const_t * dst, const_t const * a, std::size_t n, Approx f, Exact g, Domain domain)
+    {
+        if constexpr ( A == accuracy::exact ) {
+            map(dst, a, n, g);
+        }
+        else {
+            map(dst, a, n, f);
+            for ( std::size_t i = 0; i < n; ++i ) {
+                if ( ! domain(a[i]) ) { dst[i] = g(a[i]); }
+            }
+        }
+    }
+
+    template <accuracy A>
+    void apply(opcode op, const_t * dst, const_t const * a, const_t const * b, const_t const * c, std::size_t n)
+    {
+        using T = const_t;
+        switch (op) {
+            case opcode::add:  return map(dst, a, b, n, [](T x, T y) { return x + y; });
+            case opcode::sub:  return map(dst, a, b, n, [](T x, T y) { return x - y; });
+            case opcode::mul:  return map(dst, a, b, n, [](T x, T y) { return x * y; });
+            case opcode::div:  return map(dst, a, b, n, [](T x, T y) { return x / y; });
+            case opcode::mod:  return map(dst, a, b, n, [](T x, T y) { return modulus(x, y); });
+            case opcode::pow:  return map(dst, a, b, n, [](T x, T y) { return std::pow(x, y); });
+            case opcode::sin:  return approximate<A>(dst, a, n, approx::sin<A>, [](T x) { return std::sin(x); }, approx::trig::domain);
+            case opcode::cos:  return approximate<A>(dst, a, n, approx::cos<A>, [](T x) { return std::cos(x); }, approx::trig::domain);
+            case opcode::tan:  return approximate<A>(dst, a, n, approx::tan<A>, [](T x) { return std::tan(x); }, approx::trig::domain);
+            case opcode::asin: return map(dst, a, n, [](T x) { return std::asin(x); });
+            case opcode::acos: return map(dst, a, n, [](T x) { return std::acos(x); });
+            case opcode::atan: return approximate<A>(dst, a, n, approx::atan<A>, [](T x) { return std::atan(x); }, approx::arctangent::domain);
+            case opcode::exp:  return approximate<A>(dst, a, n, approx::exp<A>, [](T x) { return std::exp(x); }, approx::exponential::domain);
+            case opcode::ln:   return approximate<A>(dst, a, n, approx::ln<A>, [](T x) { return std::log(x); }, approx::logarithm::domain);
+            case opcode::abs:  return map(dst, a, n, [](T x) { return std::abs(x); });
+            case opcode::sqrt: return approximate<A>(dst, a, n, approx::sqrt<A>, [](T x) { return std::sqrt(x); }, approx::square_root::domain);
+            case opcode::cbrt: return map(dst, a, n, [](T x) { return std::cbrt(x); });
+            case opcode::sin_small:   return approximate<A>(dst, a, n, approx::sin_small<A>, [](T x) { return std::sin(x); }, anywhere);
+            case opcode::cos_small:   return approximate<A>(dst, a, n, approx::cos_small<A>, [](T x) { return std::cos(x); }, anywhere);
+            case opcode::tan_small:   return approximate<A>(dst, a, n, approx::tan_small<A>, [](T x) { return std::tan(x); }, anywhere);
+            case opcode::ln_normal:   return approximate<A>(dst, a, n, approx::ln<A>, [](T x) { return std::log(x); }, anywhere);
+            case opcode::sqrt_finite: return approximate<A>(dst, a, n, approx::sqrt<A>, [](T x) { return std::sqrt(x); }, anywhere);
+            case opcode::fma:  return map(dst, a, b, c, n, [](T x, T y, T z) { return std::fma(x, y, z); });
+            case opcode::fms:  return map(dst, a, b, c, n, [](T x, T y, T z) { return std::fma(x, y, -z); });
+            case opcode::fnma: return map(dst, a, b, c, n, [](T x, T y, T z) { return std::fma(-x, y, z); });
+            default:
+                std::fill_n(dst, n, std::numeric_limits<const_t>::quiet_NaN());
+        }
+    }
+
+    template <accuracy A>
+    void sincos(const_t * s, const_t * c, const_t const * a, std::size_t n) noexcept
+    {
+        if constexpr ( A == accuracy::exact ) {
+            for ( std::size_t i = 0; i < n; ++i ) { sincos<A>(a[i], s[i], c[i]); }
+        }
+        else {
+            for ( std::size_t i = 0; i < n; ++i ) { approx::sincos<A>(a[i], s[i], c[i]); }
+            for ( std::size_t i = 0; i < n; ++i ) {
+                if ( ! approx::trig::domain(a[i]) ) { sincos<accuracy::exact>(a[i], s[i], c[i]); }
+            }
+        }
+    }
+
+    // The values a register can take; `nan` if it can also be NaN
+    struct range
+    {
+        const_t lo   = -std::numeric_limits<const_t>::infinity();
+        const_t hi   =  std::numeric_limits<const_t>::infinity();
+        bool    nan  = true;
+
+        bool contains(const_t x) const noexcept { return lo <= x && x <= hi; }
+        bool bounded()           const noexcept { return std::isfinite(lo) && std::isfinite(hi); }
+        const_t magnitude()      const noexcept { return std::max(std::abs(lo), std::abs(hi)); }
+    };
+
+    // The bounds computed with a rounded operation are moved one ULP outward, but
+    // not across 0: a correctly rounded result has the sign of the exact one
+    inline range widen(const_t lo, const_t hi, bool nan) noexcept
+    {
+        auto constexpr inf = std::numeric_limits<const_t>::infinity();
+        if ( std::isnan(lo) || std::isnan(hi) ) {
+            return {};
+        }
+        auto const below = std::nextafter(lo, -inf);
+        auto const above = std::nextafter(hi, inf);
+        return { lo >= 0 ? std::max(const_t{0}, below) : below, hi <= 0 ? std::min(const_t{0}, above) : above, nan };
+    }
+
+    inline range monotone(range const & a, const_t (*f)(const_t), bool nan = false) noexcept
+    {
+        return widen(f(a.lo), f(a.hi), a.nan || nan);
+    }
+
+    inline range product(range const & a, range const & b) noexcept
+    {
+        const_t const p[] = { a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi };
+        auto const nan = a.nan || b.nan
+            || (a.contains(0) && ! b.bounded()) || (b.contains(0) && ! a.bounded());
+        if ( nan && (a.contains(0) || b.contains(0)) ) {
+            return {};  // 0 * inf: the products below would be NaN
+        }
+        return widen(*std::min_element(p, p + 4), *std::max_element(p, p + 4), nan);
+    }
+
+    inline range sum(range const & a, range const & b) noexcept
+    {
+        auto const nan = a.nan || b.nan || (! a.bounded() && ! b.bounded());
+        return widen(a.lo + b.lo, a.hi + b.hi, nan);
+    }
+
+    inline range negate(range const & a) noexcept
+    {
+        return { -a.hi, -a.lo, a.nan };
+    }
+
+    range apply(opcode op, range const & a, range const & b, range const & c) noexcept
+    {
+        auto constexpr pi_2 = 1.57079632679489661923;
+        switch (op) {
+            case opcode::add:  return sum(a, b);
+            case opcode::sub:  return sum(a, negate(b));
+            case opcode::mul:  return product(a, b);
+            case opcode::fma:  return sum(product(a, b), c);
+            case opcode::fms:  return sum(product(a, b), negate(c));
+            case opcode::fnma: return sum(negate(product(a, b)), c);
+            case opcode::div:
+                if ( b.contains(0) ) { return {}; }
+                return product(a, widen(1 / b.hi, 1 / b.lo, b.nan));
+            case opcode::mod: {
+                if ( b.lo > -1 && b.hi < 1 ) { return {}; }
+                // NaN as in modulus(): a divisor less than 1 in magnitude, or out of range
+                auto const m = b.magnitude();
+                auto const limit = -static_cast<const_t>(std::numeric_limits<long>::min());
+                auto const out = a.magnitude() >= limit || m >= limit;
+                return { a.lo >= 0 ? 0 : -m, a.hi <= 0 ? 0 : m, a.nan || b.nan || (b.lo < 1 && b.hi > -1) || out };
+            }
+            case opcode::pow:
+                if ( a.lo > 0 ) {
+                    const_t const p[] = {
+                        std::pow(a.lo, b.lo), std::pow(a.lo, b.hi), std::pow(a.hi, b.lo), std::pow(a.hi, b.hi)
+                    };
+                    return widen(*std::min_element(p, p + 4), *std::max_element(p, p + 4), a.nan || b.nan);
+                }
+                if ( b.lo == b.hi && b.lo > 0 && std::trunc(b.lo) == b.lo && ! b.nan ) {
+                    auto const n = b.lo;
+                    if ( std::fmod(n, 2) == 0 ) {
+                        auto const low = a.contains(0) ? 0 : std::min(std::abs(a.lo), std::abs(a.hi));
+                        return widen(std::pow(low, n), std::pow(a.magnitude(), n), a.nan);
+                    }
+                    return widen(std::pow(a.lo, n), std::pow(a.hi, n), a.nan);
+                }
+                return {};
+            case opcode::sin: case opcode::sin_small: case opcode::sincos:
+                if ( a.lo >= -pi_2 && a.hi <= pi_2 ) {
+                    return monotone(a, [](const_t x) { return std::sin(x); });
+                }
+                return { -1, 1, a.nan || ! a.bounded() };
+            case opcode::cos: case opcode::cos_small:
+                if ( a.lo >= -pi_2 && a.hi <= pi_2 ) {
+                    auto const low = std::min(std::cos(a.lo), std::cos(a.hi));
+                    return widen(low, a.contains(0) ? 1 : std::max(std::cos(a.lo), std::cos(a.hi)), a.nan);
+                }
+                return { -1, 1, a.nan || ! a.bounded() };
+            case opcode::tan: case opcode::tan_small:
+                if ( a.lo > -pi_2 && a.hi < pi_2 ) {
+                    return monotone(a, [](const_t x) { return std::tan(x); });
+                }
+                return {};
+            case opcode::asin:
+                return widen(std::asin(std::max(a.lo, -1.)), std::asin(std::min(a.hi, 1.)), a.nan || a.lo < -1 || a.hi > 1);
+            case opcode::acos:
+                return widen(std::acos(std::min(a.hi, 1.)), std::acos(std::max(a.lo, -1.)), a.nan || a.lo < -1 || a.hi > 1);
+            case opcode::atan: return monotone(a, [](const_t x) { return std::atan(x); });
+            case opcode::exp:  return monotone(a, [](const_t x) { return std::exp(x); });
+            case opcode::cbrt: return monotone(a, [](const_t x) { return std::cbrt(x); });
+            case opcode::ln: case opcode::ln_normal:
+                return widen(std::log(std::max(a.lo, 0.)), std::log(std::max(a.hi, 0.)), a.nan || a.lo < 0);
+            case opcode::sqrt: case opcode::sqrt_finite:
+                return widen(std::sqrt(std::max(a.lo, 0.)), std::sqrt(std::max(a.hi, 0.)), a.nan || a.lo < 0);
+            case opcode::abs:
+                if ( a.lo >= 0 ) { return a; }
+                if ( a.hi <= 0 ) { return negate(a); }
+                return { 0, a.magnitude(), a.nan };
+            default:
+                return {};
+        }
+    }
+
+    inline bool commutative(opcode op) noexcept
+    {
+        return op == opcode::add || op == opcode::mul;
+    }
+
+    template <typename F>
+    inline void for_each_operand(instruction & ins, F f)
+    {
+        auto const n = arity(ins.op);
+        if ( n > 0 ) { f(ins.a); }
+        if ( n > 1 ) { f(ins.b); }
+        if ( n > 2 ) { f(ins.c); }
+    }
+} // namespace detail
+
+program::program(
+    std::vector<instruction> code, std::vector<const_t> constants,
+    std::vector<char> variables, std::vector<char> parameters,
+    std::vector<const_t> bindings, accuracy level
+) :
+    _code{std::move(code)}, _constants{std::move(constants)},
+    _variables{std::move(variables)}, _parameters{std::move(parameters)},
+    _bindings{std::move(bindings)}, _accuracy{level}
+{
+    if ( _bindings.size() != _parameters.size() ) {
+        throw std::invalid_argument{"A binding for each parameter is needed"};
+    }
+    if ( _accuracy > accuracy::coarse ) {
+        throw std::invalid_argument{"Unknown accuracy"};
+    }
+    if ( ! verify(_code.data(), _code.size(), _constants.size(), _variables.size(), _parameters.size()) ) {
+        throw std::invalid_argument{"Invalid program"};
+    }
+}
+
+bool verify(
+    instruction const * code, std::size_t size,
+    std::size_t constants, std::size_t variables, std::size_t parameters
+) noexcept
+{
+    for ( std::size_t i = 0; i < size; ++i ) {
+        auto ins = code[i];
+        auto valid = ins.op <= opcode::sqrt_finite;
+        switch (ins.op) {
+            case opcode::constant:  valid = ins.a < constants;  break;
+            case opcode::variable:  valid = ins.a < variables;  break;
+            case opcode::parameter: valid = ins.a < parameters; break;
+            case opcode::sincos:    valid = ins.a < i && i + 1 < size && code[i + 1].op == opcode::pair; break;
+            case opcode::pair:      valid = i > 0 && ins.a == i - 1 && code[ins.a].op == opcode::sincos; break;
+            default:
+                detail::for_each_operand(ins, [&](auto r) { valid = valid && r < i; });
+        }
+        // The kernels read all the operands: the ones not used must be in range too
+        auto const used = std::max<std::size_t>(arity(ins.op), 1);
+        valid = valid && (used > 1 || ins.b == 0) && (used > 2 || ins.c == 0);
+        if ( ! valid ) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::uint32_t program::constant(const_t value)
+{
+    _constants.push_back(value);
+    return this->emit(opcode::constant, static_cast<std::uint32_t>(_constants.size() - 1));
+}
+
+std::uint32_t program::variable(char name)
+{
+    auto it = std::find(_variables.begin(), _variables.end(), name);
+    if ( it == _variables.end() ) {
+        it = _variables.insert(it, name);
+    }
+    return this->emit(opcode::variable, static_cast<std::uint32_t>(it - _variables.begin()));
+}
+
+std::uint32_t program::parameter(char name)
+{
+    auto it = std::find(_parameters.begin(), _parameters.end(), name);
+    if ( it == _parameters.end() ) {
+        it = _parameters.insert(it, name);
+        _bindings.push_back(std::numeric_limits<const_t>::quiet_NaN());
+    }
+    return this->emit(opcode::parameter, static_cast<std::uint32_t>(it - _parameters.begin()));
+}
+
+std::uint32_t program::emit(opcode op, std::uint32_t a, std::uint32_t b, std::uint32_t c)
+{
+    _code.push_back({op, a, b, c});
+    return static_cast<std::uint32_t>(_code.size() - 1);
+}
+
+program & program::bind(char name, const_t const & value)
+{
+    auto it = std::find(_parameters.begin(), _parameters.end(), name);
+    if ( it != _parameters.end() ) {
+        _bindings[it - _parameters.begin()] = value;
+    }
+    return *this;
+}
+
+program & program::approximate(accuracy level)
+{
+    _accuracy = level;
+    return *this;
+}
+
+char const * pass_name(pass p) noexcept
+{
+    static constexpr char const * names[] = {
+        "lower", "saturate", "fold", "simplify", "share", "reduce", "fuse", "narrow", "contract",
+    };
+    auto const i = static_cast<std::size_t>(p);
+    return i < std::size(names) ? names[i] : "invalid";
+}
+
+program & program::optimize(compile_policy const & p, std::map<char, interval> const & domains, compile_report * report)
+{
+    using clock = std::chrono::steady_clock;
+    auto const run = [&](pass which, auto && body) {
+        if ( ! p.passes.has(which) ) {
+            return;
+        }
+        auto const before = _code.size();
+        auto const start = clock::now();
+        body();
+        if ( report ) {
+            auto const elapsed = std::chrono::duration<double>(clock::now() - start).count();
+            report->push_back({ which, elapsed, before, _code.size() });
+        }
+    };
+    auto const same = [](std::vector<instruction> const & a, std::vector<instruction> const & b) {
+        return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](auto const & x, auto const & y) {
+            return x.op == y.op && x.a == y.a && x.b == y.b && x.c == y.c;
+        });
+    };
+
+    // Once: the rules already run to a fixed point, or to the end of the budget
+    run(pass::saturate, [&] { this->saturate(p.saturation); });
+
+    // A few rounds are enough in practice: each one can only shorten the program
+    std::size_t constexpr rounds = 8;
+    for ( std::size_t round = 0; round < rounds; ++round ) {
+        auto const previous = _code;
+        run(pass::fold,     [&] { this->fold(); });
+        run(pass::simplify, [&] { this->simplify(); });
+        run(pass::share,    [&] { this->share(); });
+        run(pass::reduce,   [&] { this->reduce(); });
+        run(pass::fuse,     [&] { this->fuse(p); });
+        run(pass::narrow,   [&] { this->narrow(domains); });
+        if ( p.contract ) {
+            run(pass::contract, [&] { this->contract(); });
+        }
+        if ( ! p.passes.repeat() || same(previous, _code) ) {
+            break;
+        }
+    }
+    return *this;
+}
+
+// Compute at compile time the instructions whose operands are all constants
+program & program::fold()
+{
+    auto const constant = [&](std::uint32_t r) { return _code[r].op == opcode::constant; };
+    auto const value    = [&](std::uint32_t r) { return _constants[_code[r].a]; };
+    auto const add      = [&](const_t v) {
+        _constants.push_back(v);
+        return instruction{ opcode::constant, static_cast<std::uint32_t>(_constants.size() - 1) };
+    };
+
+    for ( std::size_t i = 0; i < _code.size(); ++i ) {
+        auto & ins = _code[i];
+        auto const n = arity(ins.op);
+        if ( n == 0 || ins.op == opcode::pair ) {
+            continue;
+        }
+        auto all = true;
+        detail::for_each_operand(ins, [&](auto r) { all = all && constant(r); });
+        if ( ! all ) {
+            continue;
+        }
+        auto const a = value(ins.a);
+        auto const b = n > 1 ? value(ins.b) : 0;
+        auto const c = n > 2 ? value(ins.c) : 0;
+        if ( ins.op == opcode::sincos ) {
+            const_t sin, cos;
+            detail::sincos<accuracy::exact>(a, sin, cos);
+            _code[i + 1] = add(cos);
+            ins = add(sin);
+        }
+        else {
+            ins = add(detail::apply<accuracy::exact>(ins.op, a, b, c));
+        }
+    }
+    this->compact();
+    return *this;
+}
+
+// Drop the operations which give back their operand, bit for bit (x+0 is not
+// one of them: -0+0 is +0). The last instruction is the result and stays
+program & program::simplify()
+{
+    auto const is = [&](std::uint32_t r, const_t v) {
+        return _code[r].op == opcode::constant && _constants[_code[r].a] == v
+            && std::signbit(_constants[_code[r].a]) == std::signbit(v);
+    };
+
+    std::vector<std::uint32_t> index(_code.size());
+    for ( std::size_t i = 0; i < _code.size(); ++i ) {
+        auto & ins = _code[i];
+        detail::for_each_operand(ins, [&](auto & r) { r = index[r]; });
+        index[i] = static_cast<std::uint32_t>(i);
+
+        auto const last = i + 1 == _code.size();
+        auto same = std::numeric_limits<std::uint32_t>::max();
+        switch (ins.op) {
+            case opcode::mul:
+                if      ( is(ins.b, 1) ) { same = ins.a; }
+                else if ( is(ins.a, 1) ) { same = ins.b; }
+                break;
+            case opcode::div:
+                if ( is(ins.b, 1) ) { same = ins.a; }
+                break;
+            case opcode::sub:
+                if ( is(ins.b, 0) ) { same = ins.a; }
+                break;
+            case opcode::pow:
+                if ( is(ins.b, 1) ) { same = ins.a; }
+                else if ( is(ins.b, 0) || is(ins.b, -0.0) ) {
+                    _constants.push_back(1);    // even for a NaN base
+                    ins = { opcode::constant, static_cast<std::uint32_t>(_constants.size() - 1) };
+                }
+                break;
+            case opcode::abs:
+                if ( _code[ins.a].op == opcode::abs ) { same = ins.a; }
+                break;
+            default:
+                break;
+        }
+        if ( same != std::numeric_limits<std::uint32_t>::max() && ! last ) {
+            index[i] = same;
+        }
+    }
+    this->compact();
+    return *this;
+}
+
+// Give a single register to every value computed more than once
+program & program::share()
+{
+    std::map<std::uint64_t, std::uint32_t> pool;
+    std::vector<const_t> constants;
+    std::map<std::tuple<opcode, std::uint32_t, std::uint32_t, std::uint32_t>, std::uint32_t> seen;
+    std::vector<instruction> code;
+    std::vector<std::uint32_t> index(_code.size());
+
+    for ( std::size_t i = 0; i < _code.size(); ++i ) {
+        auto ins = _code[i];
+        if ( ins.op == opcode::constant ) {
+            std::uint64_t bits;
+            std::memcpy(&bits, &_constants[ins.a], sizeof bits);
+            auto [it, inserted] = pool.try_emplace(bits, static_cast<std::uint32_t>(constants.size()));
+            if ( inserted ) {
+                constants.push_back(_constants[ins.a]);
+            }
+            ins.a = it->second;
+        }
+        detail::for_each_operand(ins, [&](auto & r) { r = index[r]; });
+        if ( detail::commutative(ins.op) && ins.b < ins.a ) {
+            std::swap(ins.a, ins.b);
+        }
+
+        auto [it, inserted] = seen.try_emplace(
+            std::make_tuple(ins.op, ins.a, ins.b, ins.c), static_cast<std::uint32_t>(code.size())
+        );
+        if ( inserted ) {
+            code.push_back(ins);
+        }
+        index[i] = it->second;
+    }
+    _code      = std::move(code);
+    _constants = std::move(constants);
+    this->compact();
+    return *this;
+}
+
+// Replace expensive instructions with cheaper ones giving the same result:
+// x*x is exact like pow(x, 2), and so is the product by the inverse of a power
+// of two, which is itself exact
+program & program::reduce()
+{
+    auto const constant = [&](std::uint32_t r, const_t & v) {
+        if ( _code[r].op != opcode::constant ) { return false; }
+        v = _constants[_code[r].a];
+        return true;
+    };
+    auto const power_of_two = [](const_t v) {
+        int e;
+        return std::isfinite(v) && v != 0 && std::abs(std::frexp(v, &e)) == 0.5
+            && std::isnormal(1 / v);
+    };
+
+    std::vector<instruction> code;
+    std::vector<std::uint32_t> index(_code.size());
+    auto const emit = [&](instruction ins) {
+        code.push_back(ins);
+        return static_cast<std::uint32_t>(code.size() - 1);
+    };
+    auto const number = [&](const_t v) {
+        _constants.push_back(v);
+        return emit({ opcode::constant, static_cast<std::uint32_t>(_constants.size() - 1) });
+    };
+
+    for ( std::size_t i = 0; i < _code.size(); ++i ) {
+        auto ins = _code[i];
+        detail::for_each_operand(ins, [&](auto & r) { r = index[r]; });
+
+        const_t v;
+        if ( ins.op == opcode::pow && constant(_code[i].b, v) && v == 2 ) {
+            ins = { opcode::mul, ins.a, ins.a };
+        }
+        else if ( ins.op == opcode::pow && constant(_code[i].b, v) && v == -1 ) {
+            ins = { opcode::div, number(1), ins.a };
+        }
+        else if ( ins.op == opcode::div && constant(_code[i].b, v) && power_of_two(v) ) {
+            ins = { opcode::mul, ins.a, number(1 / v) };
+        }
+        index[i] = emit(ins);
+    }
+    _code = std::move(code);
+    this->compact();
+    return *this;
+}
+
+// Compute sin and cos of the same argument with one call and, if allowed, exp(-x) from exp(x)
+program & program::fuse(compile_policy const & p)
+{
+    auto constexpr none = std::numeric_limits<std::uint32_t>::max();
+    std::vector<std::uint32_t> sin_of(_code.size(), none);
+    std::vector<std::uint32_t> cos_of(_code.size(), none);
+    std::vector<std::uint32_t> exp_of(_code.size(), none);
+    for ( std::size_t i = 0; i < _code.size(); ++i ) {
+        auto const & ins = _code[i];
+        auto const r = static_cast<std::uint32_t>(i);
+        if      ( ins.op == opcode::sin ) { sin_of[ins.a] = r; }
+        else if ( ins.op == opcode::cos ) { cos_of[ins.a] = r; }
+        else if ( ins.op == opcode::exp ) { exp_of[ins.a] = r; }
+    }
+    auto negated = [&](std::uint32_t r) {
+        auto const & ins = _code[r];
+        return ins.op == opcode::sub
+            && _code[ins.a].op == opcode::constant && _constants[_code[ins.a].a] == 0
+            ? ins.b : none;
+    };
+
+    std::vector<instruction> code;
+    std::vector<std::uint32_t> index(_code.size(), none);
+    std::vector<std::uint32_t> fused(_code.size(), none);  // the sincos of an argument
+    auto emit = [&](instruction ins) {
+        code.push_back(ins);
+        return static_cast<std::uint32_t>(code.size() - 1);
+    };
+
+    for ( std::size_t i = 0; i < _code.size(); ++i ) {
+        if ( index[i] != none ) {
+            continue;   // already emitted together with its pair
+        }
+        auto ins = _code[i];
+        auto const arg = ins.a;
+        detail::for_each_operand(ins, [&](auto & r) { r = index[r]; });
+
+        // Every sin and cos of the argument, not only the last ones, reads the
+        // pair emitted at the first of them: share() may not have run
+        if ( (ins.op == opcode::sin || ins.op == opcode::cos) && sin_of[arg] != none && cos_of[arg] != none ) {
+            if ( fused[arg] == none ) {
+                fused[arg] = emit({ opcode::sincos, ins.a });
+                emit({ opcode::pair, fused[arg] });
+            }
+            index[i] = ins.op == opcode::sin ? fused[arg] : fused[arg] + 1;
+        }
+        else if ( ins.op == opcode::exp && p.reciprocal
+                  && negated(arg) != none && exp_of[negated(arg)] != none ) {
+            auto const positive = exp_of[negated(arg)];
+            if ( index[positive] == none ) {
+                index[positive] = emit({ opcode::exp, index[negated(arg)] });
+            }
+            _constants.push_back(1);
+            auto const one = emit({ opcode::constant, static_cast<std::uint32_t>(_constants.size() - 1) });
+            index[i] = emit({ opcode::div, one, index[positive] });
+        }
+        else {
+            index[i] = emit(ins);
+        }
+    }
+    _code = std::move(code);
+    this->compact();
+    return *this;
+}
+
+// Propagate the domains through the program, then use what is known about each
+// argument to pick cheaper instructions
+program & program::narrow(std::map<char, interval> const & domains)
+{
+    auto known = [&](char name) {
+        auto it = domains.find(name);
+        return it == domains.end() ? detail::range{} : detail::range{ it->second.lo, it->second.hi, false };
+    };
+
+    std::vector<detail::range> ranges(_code.size());
+    for ( std::size_t i = 0; i < _code.size(); ++i ) {
+        auto const & ins = _code[i];
+        switch (ins.op) {
+            case opcode::constant: {
+                auto const v = _constants[ins.a];
+                ranges[i] = { v, v, std::isnan(v) };
+                break;
+            }
+            case opcode::variable:  ranges[i] = known(_variables[ins.a]);  break;
+            case opcode::parameter: ranges[i] = known(_parameters[ins.a]); break;
+            case opcode::pair:
+                ranges[i] = detail::apply(opcode::cos, ranges[_code[ins.a].a], {}, {});
+                break;
+            default:
+                ranges[i] = detail::apply(ins.op, ranges[ins.a], ranges[ins.b], ranges[ins.c]);
+        }
+    }
+
+    std::vector<std::uint32_t> uses(_code.size());
+    for ( auto & ins : _code ) {
+        detail::for_each_operand(ins, [&](auto r) { ++uses[r]; });
+    }
+
+    auto constexpr pi_4 = approx::trig::small;
+    auto constexpr max  = std::numeric_limits<const_t>::max();
+    std::vector<std::uint32_t> index(_code.size());
+    for ( std::size_t i = 0; i < _code.size(); ++i ) {
+        auto & ins = _code[i];
+        detail::for_each_operand(ins, [&](auto & r) { r = index[r]; });
+        index[i] = static_cast<std::uint32_t>(i);
+
+        auto const & a = ranges[arity(ins.op) > 0 ? ins.a : i];
+        auto const last = i + 1 == _code.size();
+        switch (ins.op) {
+            case opcode::abs:
+                if ( a.lo < 0 ) {
+                    break;
+                }
+                if ( ! last ) {
+                    index[i] = ins.a;
+                }
+                // The result is the last instruction: it becomes the one of the
+                // argument, which compact() drops if nobody else reads it
+                else if ( auto const & arg = _code[ins.a];
+                          arg.op != opcode::sincos && arg.op != opcode::pair
+                          && (arity(arg.op) == 0 || uses[ins.a] == 1) ) {
+                    ins = arg;
+                }
+                break;
+            case opcode::sin: case opcode::cos: case opcode::tan:
+                if ( ! a.nan && a.magnitude() <= pi_4 ) {
+                    ins.op = ins.op == opcode::sin ? opcode::sin_small
+                           : ins.op == opcode::cos ? opcode::cos_small : opcode::tan_small;
+                }
+                break;
+            case opcode::ln:
+                if ( ! a.nan && a.lo >= std::numeric_limits<const_t>::min() && a.hi <= max ) {
+                    ins.op = opcode::ln_normal;
+                }
+                break;
+            case opcode::sqrt:
+                // The coarse kernel is not valid on subnormals
+                if ( ! a.nan && a.hi <= max
+                     && a.lo >= (_accuracy == accuracy::coarse ? std::numeric_limits<const_t>::min() : 0) ) {
+                    ins.op = opcode::sqrt_finite;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    this->compact();
+    return *this;
+}
+
+program & program::contract()
+{
+    std::vector<std::uint32_t> uses(_code.size());
+    for ( auto & ins : _code ) {
+        detail::for_each_operand(ins, [&](auto r) { ++uses[r]; });
+    }
+
+    // A product read by someone else must be computed anyway: fusing it would only duplicate it
+    auto fusable = [&](std::uint32_t r) { return _code[r].op == opcode::mul && uses[r] == 1; };
+    for ( auto & ins : _code ) {
+        if ( ins.op == opcode::add ) {
+            if ( fusable(ins.a) ) {
+                auto const & m = _code[ins.a];
+                ins = { opcode::fma, m.a, m.b, ins.b };
+            }
+            else if ( fusable(ins.b) ) {
+                auto const & m = _code[ins.b];
+                ins = { opcode::fma, m.a, m.b, ins.a };
+            }
+        }
+        else if ( ins.op == opcode::sub ) {
+            if ( fusable(ins.a) ) {
+                auto const & m = _code[ins.a];
+                ins = { opcode::fms, m.a, m.b, ins.b };
+            }
+            else if ( fusable(ins.b) ) {
+                auto const & m = _code[ins.b];
+                ins = { opcode::fnma, m.a, m.b, ins.a };
+            }
+        }
+    }
+    this->compact();
+    return *this;
+}
+
+// Remove the instructions which do not contribute to the result and renumber the others
+void program::compact()
+{
+    if ( _code.empty() ) {
+        return;
+    }
+    std::vector<bool> live(_code.size());
+    live.back() = true;
+    for ( auto i = _code.size(); i-- > 0; ) {
+        if ( live[i] ) {
+            detail::for_each_operand(_code[i], [&](auto r) { live[r] = true; });
+        }
+    }
+    // Both the results of a pair are written together, even if only one of them is read
+    for ( std::size_t i = 0; i < _code.size(); ++i ) {
+        if ( live[i] && _code[i].op == opcode::sincos ) {
+            live[i + 1] = true;
+        }
+    }
+
+    std::vector<std::uint32_t> index(_code.size());
+    std::vector<const_t> constants;
+    std::size_t size = 0;
+    for ( std::size_t i = 0; i < _code.size(); ++i ) {
+        if ( ! live[i] ) {
+            continue;
+        }
+        auto ins = _code[i];
+        if ( ins.op == opcode::constant ) {
+            constants.push_back(_constants[ins.a]);
+            ins.a = static_cast<std::uint32_t>(constants.size() - 1);
+        }
+        detail::for_each_operand(ins, [&](auto & r) { r = index[r]; });
+        index[i] = static_cast<std::uint32_t>(size);
+        _code[size++] = ins;
+    }
+    _code.resize(size);
+    _constants = std::move(constants);
+}
+
+namespace detail
+{
+    // Room on the stack for an evaluation without a workspace: blocks of full
+    // width up to 64 instructions, narrower past them
+    std::size_t constexpr stack_instructions = 1024;
+    std::size_t constexpr stack_registers    = 4096;
+
+    // Memory reused by the evaluations of a thread, for the programs too long for
+    // the stack: only a program larger than all the previous ones makes it grow
+    template <typename T>
+    T * scratch(std::size_t size)
+    {
+        thread_local std::vector<T> buffer;
+        if ( buffer.size() < size ) {
+            buffer.resize(size);
+        }
+        return buffer.data();
+    }
+
+    template <accuracy A>
+    const_t run(image const & p, const_t const & x, const_t const * params, std::size_t count, const_t * r)
+    {
+        for ( std::size_t i = 0; i < p.size; ++i ) {
+            auto const & ins = p.code[i];
+            switch (ins.op) {
+                case opcode::constant:  r[i] = p.constants[ins.a]; break;
+                case opcode::variable:  r[i] = x; break;
+                case opcode::parameter: r[i] = ins.a < count ? params[ins.a] : p.bindings[ins.a]; break;
+                case opcode::sincos:    sincos<A>(r[ins.a], r[i], r[i + 1]); break;
+                case opcode::pair:      break;
+                default:
+                    r[i] = apply<A>(ins.op, r[ins.a], r[ins.b], r[ins.c]);
+            }
+        }
+        return p.size == 0 ? const_t{0} : r[p.size - 1];
+    }
+
+    // Blocks of `lanes` values, at most program::lanes: `registers` holds one block
+    // per instruction, `source` and `varying` one entry
+    template <accuracy A>
+    void run(
+        image const & p, const_t const * in, const_t * out, std::size_t n, const_t const * params, std::size_t count,
+        const_t * registers, std::size_t lanes, const_t const ** source, unsigned char * varying
+    )
+    {
+        if ( p.size == 0 ) {
+            std::fill_n(out, n, const_t{0});
+            return;
+        }
+
+        // What does not depend on the variable is the same for every block: the
+        // leaves, and the instructions of only leaves and parameters, are computed
+        // once per call and not once per block
+        for ( std::size_t i = 0; i < p.size; ++i ) {
+            auto const & ins = p.code[i];
+            auto const k = arity(ins.op);
+            auto * block = &registers[i * lanes];
+            source[i] = block;
+            varying[i] = ins.op == opcode::variable
+                      || (k > 0 && varying[ins.a]) || (k > 1 && varying[ins.b]) || (k > 2 && varying[ins.c]);
+            if ( varying[i] ) {
+                continue;
+            }
+            switch (ins.op) {
+                case opcode::constant:
+                    std::fill_n(block, lanes, p.constants[ins.a]);
+                    break;
+                case opcode::parameter:
+                    std::fill_n(block, lanes, ins.a < count ? params[ins.a] : p.bindings[ins.a]);
+                    break;
+                case opcode::sincos:
+                    sincos<A>(source[ins.a][0], block[0], block[lanes]);
+                    std::fill_n(block, lanes, block[0]);
+                    std::fill_n(block + lanes, lanes, block[lanes]);
+                    break;
+                case opcode::pair:
+                    break;
+                default:
+                    std::fill_n(block, lanes, apply<A>(ins.op, source[ins.a][0], source[ins.b][0], source[ins.c][0]));
+            }
+        }
+
+        for ( std::size_t base = 0; base < n; base += lanes ) {
+            auto const m = std::min(lanes, n - base);
+            for ( std::size_t i = 0; i < p.size; ++i ) {
+                auto const & ins = p.code[i];
+                auto * block = &registers[i * lanes];
+                if ( ! varying[i] ) {
+                    continue;
+                }
+                if ( ins.op == opcode::variable ) {
+                    source[i] = in + base;
+                }
+                else if ( ins.op == opcode::sincos ) {
+                    sincos<A>(block, block + lanes, source[ins.a], m);
+                }
+                else if ( ins.op != opcode::pair ) {
+                    apply<A>(
+                        ins.op, block,
+                        source[ins.a], source[ins.b], source[ins.c], m
+                    );
+                }
+            }
+            std::copy_n(source[p.size - 1], m, out + base);
+        }
+    }
+} // namespace detail
+
+namespace detail
+{
+    template <typename... Args>
+    const_t scalar(image const & p, Args... args)
+    {
+        switch (p.precision) {
+            case accuracy::faithful: return run<accuracy::faithful>(p, args...);
+            case accuracy::single:   return run<accuracy::single>(p, args...);
+            case accuracy::coarse:   return run<accuracy::coarse>(p, args...);
+            default:                 return run<accuracy::exact>(p, args...);
+        }
+    }
+
+    template <typename... Args>
+    void batch(image const & p, Args... args)
+    {
+        switch (p.precision) {
+            case accuracy::faithful: return run<accuracy::faithful>(p, args...);
+            case accuracy::single:   return run<accuracy::single>(p, args...);
+            case accuracy::coarse:   return run<accuracy::coarse>(p, args...);
+            default:                 return run<accuracy::exact>(p, args...);
+        }
+    }
+} // namespace detail
+
+workspace & workspace::reserve(image const & p)
+{
+    if ( _registers.size() < p.size * program::lanes ) {
+        _registers.resize(p.size * program::lanes);
+    }
+    if ( _source.size() < p.size ) {
+        _source.resize(p.size);
+        _varying.resize(p.size);
+    }
+    return *this;
+}
+
+const_t execute(image const & p, const_t const & x, const_t const * params, std::size_t count) noexcept
+{
+    EXPR_PHASE(eval);
+    if ( p.size > detail::stack_instructions ) {
+        return detail::scalar(p, x, params, count, detail::scratch<const_t>(p.size));
+    }
+    const_t registers[detail::stack_instructions];
+    return detail::scalar(p, x, params, count, registers);
+}
+
+void execute(
+    image const & p, const_t const * in, const_t * out, std::size_t n, const_t const * params, std::size_t count
+) noexcept
+{
+    EXPR_PHASE(eval);
+    if ( p.size > detail::stack_instructions ) {
+        auto * registers = detail::scratch<const_t>(p.size * program::lanes);
+        auto * source    = detail::scratch<const_t const *>(p.size);
+        auto * varying   = detail::scratch<unsigned char>(p.size);
+        return detail::batch(p, in, out, n, params, count, registers, program::lanes, source, varying);
+    }
+    const_t registers[detail::stack_registers];
+    const_t const * source[detail::stack_instructions];
+    unsigned char varying[detail::stack_instructions];
+    auto const lanes = std::min(program::lanes, detail::stack_registers / std::max<std::size_t>(p.size, 1));
+    detail::batch(p, in, out, n, params, count, registers, lanes, source, varying);
+}
+
+const_t execute(
+    image const & p, const_t const & x, const_t const * params, std::size_t count, workspace & w
+) noexcept
+{
+    if ( w._registers.size() < p.size ) {
+        return execute(p, x, params, count);
+    }
+    EXPR_PHASE(eval);
+    return detail::scalar(p, x, params, count, w._registers.data());
+}
+
+void execute(
+    image const & p, const_t const * in, const_t * out, std::size_t n,
+    const_t const * params, std::size_t count, workspace & w
+) noexcept
+{
+    auto const lanes = std::min(program::lanes, w._registers.size() / std::max<std::size_t>(p.size, 1));
+    if ( lanes == 0 || w._source.size() < p.size ) {
+        return execute(p, in, out, n, params, count);
+    }
+    EXPR_PHASE(eval);
+    detail::batch(p, in, out, n, params, count, w._registers.data(), lanes, w._source.data(), w._varying.data());
+}
+
+status classify(span<const_t const> values) noexcept
+{
+    auto result = status::ok;
+    for ( auto value : values ) {
+        result = std::max(result, classify(value));
+    }
+    return result;
+}
+
+char const * mnemonic(opcode op) noexcept
+{
+    static constexpr char const * names[] = {
+        "constant", "variable", "parameter",
+        "add", "sub", "mul", "div", "mod", "pow",
+        "sin", "cos", "tan", "asin", "acos", "atan", "exp", "ln", "abs", "sqrt", "cbrt",
+        "fma", "fms", "fnma", "sincos", "pair",
+        "sin_small", "cos_small", "tan_small", "ln_normal", "sqrt_finite",
+    };
+    auto const i = static_cast<std::size_t>(op);
+    return i < std::size(names) ? names[i] : "invalid";
+}
+
+// The polynomials of the approximations cost a fraction of libm, less the coarser they are
+double cost(opcode op, accuracy level) noexcept
+{
+    static constexpr double scale[] = { 1.0, 0.6, 0.45, 0.35 };
+    auto const approximated = [&](double exact) { return exact * scale[static_cast<std::size_t>(level)]; };
+    switch (op) {
+        case opcode::constant: case opcode::variable: case opcode::parameter: case opcode::pair:
+            return 0;
+        case opcode::add: case opcode::sub: case opcode::mul: case opcode::abs:
+            return 1;
+        case opcode::fma: case opcode::fms: case opcode::fnma:
+            return 1;
+        case opcode::div:  return 4;
+        case opcode::mod:  return 25;   // two conversions and an integer division
+        case opcode::pow:  return 60;
+        case opcode::sqrt: case opcode::sqrt_finite:
+            return level == accuracy::exact ? 5 : approximated(8);
+        case opcode::cbrt: return 25;
+        case opcode::asin: case opcode::acos:
+            return 25;
+        case opcode::sin:  case opcode::cos:  return approximated(20);
+        case opcode::tan:  return approximated(30);
+        case opcode::atan: return approximated(20);
+        case opcode::exp:  return approximated(15);
+        case opcode::ln:   return approximated(18);
+        case opcode::sincos:    return approximated(25);
+        case opcode::sin_small: case opcode::cos_small:
+            return approximated(12);
+        case opcode::tan_small: return approximated(18);
+        case opcode::ln_normal: return approximated(14);
+        default:
+            return 0;
+    }
+}
+
+double cost(program const & p) noexcept
+{
+    double result = 0;
+    for ( auto const & ins : p.code() ) {
+        result += cost(ins.op, p.precision());
+    }
+    return result;
+}
+
+std::string format(const_t value)
+{
+    char text[32];
+    if ( std::trunc(value) == value && std::abs(value) < 1e15 ) {
+        std::snprintf(text, sizeof(text), "%.0f", value);
+        return text;
+    }
+    for ( int digits = 1; digits < 17; ++digits ) {
+        std::snprintf(text, sizeof(text), "%.*g", digits, value);
+        if ( std::strtod(text, nullptr) == value ) {
+            return text;
+        }
+    }
+    std::snprintf(text, sizeof(text), "%.17g", value);
+    return text;
+}
+
+std::string listing(program const & p)
+{
+    std::string result;
+    auto const & code = p.code();
+    for ( std::size_t i = 0; i < code.size(); ++i ) {
+        auto ins = code[i];
+        auto line = "r" + std::to_string(i) + " = " + mnemonic(ins.op);
+        switch (ins.op) {
+            case opcode::constant:
+                line += " " + format(p.constants()[ins.a]);
+                break;
+            case opcode::variable:
+                line += std::string{" "} + p.variables()[ins.a];
+                break;
+            case opcode::parameter: {
+                line += std::string{" "} + p.parameters()[ins.a];
+                auto const bound = p.bindings()[ins.a];
+                line += std::isnan(bound) ? " (unbound)" : " = " + format(bound);
+                break;
+            }
+            case opcode::pair:
+                line += " r" + std::to_string(ins.a) + " (cos)";
+                break;
+            default:
+                detail::for_each_operand(ins, [&](auto r) { line += " r" + std::to_string(r); });
+        }
+        auto const c = format(cost(ins.op, p.precision()));
+        line.resize(std::max<std::size_t>(line.size() + 1, 40 - c.size()), ' ');
+        result += line + c + '\n';
+    }
+    return result;
+}
+
+image program::view() const noexcept
+{
+    return { _code.data(), _code.size(), _constants.data(), _bindings.data(), _accuracy };
+}
+
+const_t program::operator()(const_t const & x) const noexcept
+{
+    return execute(this->view(), x, nullptr, 0);
+}
+
+const_t program::operator()(const_t const & x, const_t const * params, std::size_t count) const noexcept
+{
+    return execute(this->view(), x, params, count);
+}
+
+const_t program::operator()(const_t const & x, status & s) const noexcept
+{
+    auto const result = execute(this->view(), x, nullptr, 0);
+    s = classify(result);
+    return result;
+}
+
+void program::operator()(const_t const * in, const_t * out, std::size_t n) const noexcept
+{
+    execute(this->view(), in, out, n, nullptr, 0);
+}
+
+void program::operator()(
+    const_t const * in, const_t * out, std::size_t n, const_t const * params, std::size_t count
+) const noexcept
+{
+    execute(this->view(), in, out, n, params, count);
+}
+
+const_t program::operator()(const_t const & x, const_t const * params, std::size_t count, workspace & w) const noexcept
+{
+    return execute(this->view(), x, params, count, w);
+}
+
+void program::operator()(
+    const_t const * in, const_t * out, std::size_t n, const_t const * params, std::size_t count, workspace & w
+) const noexcept
+{
+    execute(this->view(), in, out, n, params, count, w);
+}
+
+static_assert(std::is_same_v<const_t, double>, "The C interface passes doubles");
+
+c_function to_c_function(program const & p) noexcept
+{
+    return { expr_program_eval, const_cast<program *>(&p) };
+}
+
+c_batch to_c_batch(program const & p) noexcept
+{
+    return { expr_program_eval_batch, const_cast<program *>(&p) };
+}
+
+} // namespace expr
+
+extern "C" double expr_program_eval(double x, void * context) noexcept
+{
+    auto const & p = *static_cast<expr::program const *>(context);
+    return expr::execute(p.view(), x, nullptr, 0);
+}
+
+extern "C" void expr_program_eval_batch(double const * in, double * out, std::size_t n, void * context) noexcept
+{
+    auto const & p = *static_cast<expr::program const *>(context);
+    expr::execute(p.view(), in, out, n, nullptr, 0);
+}
@@ -0,0 +1,366 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : program
+ * @created     : Friday October 16, 2026 10:12:31 CEST
+ * @license     : MIT
+ * */
+
+#ifndef PROGRAM_HPP
+#define PROGRAM_HPP
+
+#include <map>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+#include "expression.hpp"
+#include "approx.hpp"
+
+namespace expr
+{
+
+enum class opcode : std::uint8_t
+{
+    constant,   // a: index in the constant pool
+    variable,   // a: index in the variable list
+    parameter,  // a: index in the parameter list
+    add, sub, mul, div, mod, pow,
+    sin, cos, tan, asin, acos, atan, exp, ln, abs, sqrt, cbrt,
+    fma,        // a * b + c
+    fms,        // a * b - c
+    fnma,       // c - a * b
+    sincos,     // sin(a), and cos(a) in the following register
+    pair,       // second result of the instruction in a: it does nothing by itself
+    sin_small, cos_small, tan_small,    // |a| <= pi/4: no argument reduction
+    ln_normal,                          // a positive, normal and finite
+    sqrt_finite,                        // a non-negative and finite, normal at the coarse level
+};
+
+constexpr std::size_t arity(opcode op) noexcept
+{
+    switch (op) {
+        case opcode::constant: case opcode::variable: case opcode::parameter:
+            return 0;
+        case opcode::add: case opcode::sub: case opcode::mul:
+        case opcode::div: case opcode::mod: case opcode::pow:
+            return 2;
+        case opcode::fma: case opcode::fms: case opcode::fnma:
+            return 3;
+        default:
+            return 1;
+    }
+}
+
+// The name of the opcode in listings
+char const * mnemonic(opcode op) noexcept;
+
+// A static estimate of one evaluation of the instruction, in cycles of a recent
+// x86-64 core (the latency of the arithmetic, about what libm takes for the
+// functions): good to compare formulas, not to predict their time
+double cost(opcode op, accuracy level = accuracy::exact) noexcept;
+
+// Every instruction writes the register with its own index; a, b and c are the
+// registers of the operands (or an index in a pool for the leaves)
+struct instruction
+{
+    opcode op;
+    std::uint32_t a = 0;
+    std::uint32_t b = 0;
+    std::uint32_t c = 0;
+};
+
+// Changes whenever lowering, the passes or the meaning of an opcode change: a
+// program stored by another version must be compiled again
+inline constexpr std::uint32_t compiler_version = 3;
+
+// The passes of compile(), in the order they run. Lowering always runs; the
+// others change the program only where the result stays the same, except
+// contract and fuse, which also need the permission of the compile_policy, and
+// saturate, which is in no level and has to be enabled by itself
+enum class pass : std::uint8_t
+{
+    lower,      // the tree into instructions
+    saturate,   // the cheapest of the forms found by algebraic and trigonometric rewriting
+    fold,       // instructions of constants into constants
+    simplify,   // x*1, x/1, x-0, x^1, x^0, abs(abs(x))
+    share,      // a single register for every value computed more than once
+    reduce,     // x^2 into x*x, x^-1 into 1/x, x/2^k into x*2^-k
+    fuse,       // sin and cos of the same argument into sincos
+    narrow,     // cheaper instructions where the domains allow them
+    contract,   // a*b+c into fma(a,b,c)
+};
+inline constexpr std::size_t pass_count = 9;
+
+char const * pass_name(pass p) noexcept;
+
+// Which passes compile() runs. The levels trade compile time for evaluation
+// time: O0 runs none, O1 only fold and share, O2 all of them but saturate and O3
+// the same again and again, until they change nothing
+class pass_set
+{
+    std::uint16_t _enabled = 0;
+    bool _repeat = false;
+
+public:
+    constexpr pass_set() noexcept = default;
+
+    static constexpr pass_set level(unsigned n) noexcept
+    {
+        pass_set result;
+        if ( n >= 1 ) {
+            result.enable(pass::fold).enable(pass::share);
+        }
+        if ( n >= 2 ) {
+            result.enable(pass::simplify).enable(pass::reduce).enable(pass::fuse)
+                  .enable(pass::narrow).enable(pass::contract);
+        }
+        result._repeat = n >= 3;
+        return result;
+    }
+
+    constexpr pass_set & enable(pass p, bool on = true) noexcept
+    {
+        auto const bit = static_cast<std::uint16_t>(1u << static_cast<unsigned>(p));
+        _enabled = on ? _enabled | bit : _enabled & ~bit;
+        return *this;
+    }
+
+    constexpr pass_set & disable(pass p) noexcept { return this->enable(p, false); }
+
+    constexpr bool has(pass p) const noexcept
+    {
+        return p == pass::lower || (_enabled >> static_cast<unsigned>(p) & 1u);
+    }
+
+    constexpr bool repeat() const noexcept { return _repeat; }
+};
+
+// The limits of the saturate pass, which stops at the first one it reaches: the
+// rewriting can go on for long on large formulas, most of all on long sums and
+// products, which it can reorder in many ways
+struct saturation_budget
+{
+    std::size_t iterations = 16;    // of all the rules over all the forms
+    std::size_t nodes = 20000;      // forms known, over all the subexpressions
+    double seconds = 1;
+};
+
+struct compile_policy
+{
+    bool contract   = false;  // fuse a*b+c into fma(a,b,c): one rounding instead of two
+    bool reciprocal = false;  // exp(-x) as 1/exp(x) if exp(x) is needed too: one rounding more
+    accuracy precision = accuracy::exact;   // of sin, cos, tan, exp, ln, atan and sqrt
+    pass_set passes = pass_set::level(2);
+    saturation_budget saturation;
+};
+
+// What a pass did: how long it took and how many instructions it left (for
+// lowering, `before` counts the nodes of the tree)
+struct pass_record
+{
+    pass which;
+    double seconds;
+    std::size_t before;
+    std::size_t after;
+
+    std::size_t removed() const noexcept { return before > after ? before - after : 0; }
+};
+
+using compile_report = std::vector<pass_record>;
+
+// How an evaluation went, for who needs more than the NaN in the result: the
+// kernels never throw, a domain error or an overflow only shows in the value
+enum class status : std::uint8_t { ok, infinite, not_a_number, };
+
+inline status classify(const_t value) noexcept
+{
+    return std::isnan(value) ? status::not_a_number
+         : std::isinf(value) ? status::infinite
+         : status::ok;
+}
+
+// The worst of the values
+status classify(span<const_t const> values) noexcept;
+
+// The `%` of the expressions, the remainder of the integer parts: NaN for an
+// operand not finite or out of the range of long, or a divisor less than 1 in
+// magnitude. Every evaluation and every folding uses this one
+inline const_t modulus(const_t a, const_t b) noexcept
+{
+    // -LONG_MIN is a power of two, exact as a double; LONG_MIN itself is left out,
+    // so LONG_MIN % -1 cannot overflow
+    constexpr auto limit = -static_cast<const_t>(std::numeric_limits<long>::min());
+    if ( ! (std::abs(a) < limit && std::abs(b) < limit) || static_cast<long>(b) == 0 ) {
+        return std::numeric_limits<const_t>::quiet_NaN();
+    }
+    return static_cast<const_t>(static_cast<long>(a) % static_cast<long>(b));
+}
+
+// The arrays a program is evaluated from: the ones of a program object, or the
+// ones of a serialized program, used where they are
+struct image
+{
+    instruction const * code = nullptr;
+    std::size_t size = 0;
+    const_t const * constants = nullptr;
+    const_t const * bindings = nullptr;
+    accuracy precision = accuracy::exact;
+};
+
+// Whether every operand is in range and every sincos is followed by its pair:
+// code from elsewhere must be checked before it is executed
+bool verify(
+    instruction const * code, std::size_t size,
+    std::size_t constants, std::size_t variables, std::size_t parameters
+) noexcept;
+
+// Memory for the registers of evaluations, kept by the caller: once reserved for
+// a program, evaluating it with the workspace does not allocate. A workspace too
+// small for a program is used with narrower blocks, or not at all. One thread at
+// a time
+class workspace
+{
+    std::vector<const_t> _registers;
+    std::vector<const_t const *> _source;
+    std::vector<unsigned char> _varying;
+
+public:
+    workspace() = default;
+    explicit workspace(image const & p) { this->reserve(p); }
+
+    // Room for a full block of values for each instruction of `p`
+    workspace & reserve(image const & p);
+
+    friend const_t execute(
+        image const & p, const_t const & x, const_t const * params, std::size_t count, workspace & w
+    ) noexcept;
+    friend void execute(
+        image const & p, const_t const * in, const_t * out, std::size_t n,
+        const_t const * params, std::size_t count, workspace & w
+    ) noexcept;
+};
+
+// Same as the operators of program. Without a workspace the registers are on the
+// stack, in narrower blocks for longer programs; only the programs of more than
+// a thousand instructions use memory kept by the thread, which grows on the
+// first call
+const_t execute(image const & p, const_t const & x, const_t const * params, std::size_t count) noexcept;
+void execute(
+    image const & p, const_t const * in, const_t * out, std::size_t n, const_t const * params, std::size_t count
+) noexcept;
+const_t execute(
+    image const & p, const_t const & x, const_t const * params, std::size_t count, workspace & w
+) noexcept;
+void execute(
+    image const & p, const_t const * in, const_t * out, std::size_t n,
+    const_t const * params, std::size_t count, workspace & w
+) noexcept;
+
+// A flat, already ordered form of an expression: it is evaluated with a single
+// pass over `code`, one value (or one block of values) per instruction
+class program
+{
+    std::vector<instruction> _code;
+    std::vector<const_t> _constants;
+    std::vector<char> _variables;
+    std::vector<char> _parameters;
+    std::vector<const_t> _bindings;
+    accuracy _accuracy = accuracy::exact;
+
+public:
+    static constexpr std::size_t lanes = 64;
+
+    program() = default;
+    // From the parts of a program built elsewhere (e.g. read from a file): throws
+    // std::invalid_argument if they do not make a valid program
+    program(
+        std::vector<instruction> code, std::vector<const_t> constants,
+        std::vector<char> variables, std::vector<char> parameters,
+        std::vector<const_t> bindings, accuracy level
+    );
+
+    std::uint32_t constant(const_t value);
+    std::uint32_t variable(char name);
+    std::uint32_t parameter(char name);
+    std::uint32_t emit(opcode op, std::uint32_t a, std::uint32_t b = 0, std::uint32_t c = 0);
+
+    program & bind(char name, const_t const & value);
+    program & approximate(accuracy level);
+    // The passes of `p.passes` after lowering, each one recorded in `report` if given
+    program & optimize(compile_policy const & p, std::map<char, interval> const & domains, compile_report * report = nullptr);
+    // Equality saturation: every form of every subexpression reachable with the
+    // rules is kept in an e-graph, and the one of least cost() is extracted. The
+    // rules are identities of the real numbers which hold at infinities and NaN
+    // too, so the result can differ from the original in rounding, and where an
+    // intermediate value overflows
+    program & saturate(saturation_budget const & budget);
+    program & fold();
+    program & simplify();
+    program & share();
+    program & reduce();
+    program & fuse(compile_policy const & p);
+    program & contract();
+    program & narrow(std::map<char, interval> const & domains);
+
+    // The parameters are the bound ones, or `params` in the order of parameters();
+    // the slots past `count` fall back on the bound values
+    const_t operator()(const_t const & x) const noexcept;
+    const_t operator()(const_t const & x, const_t const * params, std::size_t count) const noexcept;
+    const_t operator()(const_t const & x, status & s) const noexcept;
+    void operator()(const_t const * in, const_t * out, std::size_t n) const noexcept;
+    void operator()(const_t const * in, const_t * out, std::size_t n, const_t const * params, std::size_t count) const noexcept;
+    // The same with the registers in `w`
+    const_t operator()(const_t const & x, const_t const * params, std::size_t count, workspace & w) const noexcept;
+    void operator()(
+        const_t const * in, const_t * out, std::size_t n, const_t const * params, std::size_t count, workspace & w
+    ) const noexcept;
+
+    std::vector<instruction> const & code()       const noexcept { return _code; }
+    std::vector<const_t>     const & constants()  const noexcept { return _constants; }
+    std::vector<char>        const & variables()  const noexcept { return _variables; }
+    std::vector<char>        const & parameters() const noexcept { return _parameters; }
+    std::vector<const_t>     const & bindings()   const noexcept { return _bindings; }
+    accuracy precision() const noexcept { return _accuracy; }
+    image view() const noexcept;
+private:
+    void compact();
+};
+
+// A plain function pointer and its context, for C code and numeric libraries
+// (integrators, root finders...) which take a `double f(double, void *)`: the
+// context is the program, which has to outlive every call
+struct c_function
+{
+    double (*function)(double, void *);
+    void * context;
+
+    double operator()(double x) const noexcept { return function(x, context); }
+};
+
+struct c_batch
+{
+    void (*function)(double const *, double *, std::size_t, void *);
+    void * context;
+
+    void operator()(double const * in, double * out, std::size_t n) const noexcept { function(in, out, n, context); }
+};
+
+// The sum of the cost of the instructions, and one line per instruction with its cost
+double cost(program const & p) noexcept;
+std::string listing(program const & p);
+
+// The shortest text which reads back as `value`
+std::string format(const_t value);
+
+c_function to_c_function(program const & p) noexcept;
+c_batch to_c_batch(program const & p) noexcept;
+
+} // namespace expr
+
+// The functions behind c_function and c_batch: `context` points to an expr::program
+extern "C" double expr_program_eval(double x, void * context) noexcept;
+extern "C" void expr_program_eval_batch(double const * in, double * out, std::size_t n, void * context) noexcept;
+
+#endif /* PROGRAM_HPP */
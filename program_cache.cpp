@@ -0,0 +1,157 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : program_cache
+ * @created     : Friday October 16, 2026 16:27:40 CEST
+ * @license     : MIT
+ * */
+
+#include <stdexcept>
+#include <algorithm>
+#include <functional>
+#include "program_cache.hpp"
+
+
+namespace expr
+{
+
+std::size_t program_cache::hasher::operator()(key const & k) const noexcept
+{
+    auto h = std::hash<std::string_view>{}(k.source);
+    h ^= (static_cast<std::size_t>(k.variable) << 8 | static_cast<std::size_t>(k.policy)) + 0x9e3779b97f4a7c15u + (h << 6) + (h >> 2);
+    return h;
+}
+
+program_cache::program_cache(std::size_t capacity, std::size_t shards) :
+    _capacity{ std::max<std::size_t>(capacity / std::max<std::size_t>(shards, 1), 1) }
+{
+    shards = std::max<std::size_t>(shards, 1);
+    for ( std::size_t i = 0; i < shards; ++i ) {
+        _shards.push_back(std::make_unique<shard>());
+    }
+}
+
+// The expression is compiled without holding the lock; if two threads miss the
+// same key at the same time, the second one to come back uses the first program
+std::shared_ptr<program const> program_cache::get(std::string_view source, expression::policy p, char x)
+{
+    auto const k = key{source, p, x};
+    auto & s = *_shards[hasher{}(k) % _shards.size()];
+    {
+        std::lock_guard lock{s.mutex};
+        if ( auto it = s.index.find(k); it != s.index.end() ) {
+            ++s.hits;
+            s.order.splice(s.order.begin(), s.order, it->second);
+            return it->second->code;
+        }
+        ++s.misses;
+    }
+
+    std::shared_ptr<program const> code;
+    if ( auto compiled = expression{p, std::string{source}}.compile(x) ) {
+        code = std::make_shared<program const>(std::move(*compiled));
+    }
+
+    std::lock_guard lock{s.mutex};
+    if ( auto it = s.index.find(k); it != s.index.end() ) {
+        s.order.splice(s.order.begin(), s.order, it->second);
+        return it->second->code;
+    }
+    s.order.push_front(entry{ std::string{source}, p, x, code });
+    s.index.emplace(key{s.order.front().source, p, x}, s.order.begin());
+    if ( s.order.size() > _capacity ) {
+        auto const & last = s.order.back();
+        s.index.erase(key{last.source, last.policy, last.variable});
+        s.order.pop_back();
+        ++s.evictions;
+    }
+    return code;
+}
+
+auto program_cache::stats() const
+    -> statistics
+{
+    statistics result;
+    for ( auto const & s : _shards ) {
+        std::lock_guard lock{s->mutex};
+        result.hits      += s->hits;
+        result.misses    += s->misses;
+        result.evictions += s->evictions;
+        result.size      += s->order.size();
+    }
+    return result;
+}
+
+void program_cache::clear()
+{
+    for ( auto const & s : _shards ) {
+        std::lock_guard lock{s->mutex};
+        s->index.clear();
+        s->order.clear();
+    }
+}
+
+program_cache & program_cache::global()
+{
+    static program_cache cache;
+    return cache;
+}
+
+namespace detail
+{
+    // compute() and parse_function() cannot set parameters: any one left in the
+    // program was never assigned
+    void check_assigned(program const & code)
+    {
+        if ( ! code.parameters().empty() ) {
+            throw std::logic_error{std::string{"Unassigned parameter "} + code.parameters().front()};
+        }
+    }
+} // namespace detail
+
+// No character is ever parsed as '\0': every letter is a parameter
+auto compute(std::string const & source)
+    -> std::optional<const_t>
+{
+    auto const code = program_cache::global().get(source, expression::policy::build, '\0');
+    if ( ! code ) { return {}; }
+    detail::check_assigned(*code);
+    return (*code)(const_t{0});
+}
+
+auto compute(std::string && source)
+    -> std::optional<const_t>
+{
+    return compute(static_cast<std::string const &>(source));
+}
+
+auto compute(std::string const & source, char x, const_t const & value)
+    -> std::optional<const_t>
+{
+    auto const code = program_cache::global().get(source, expression::policy::build, x);
+    if ( ! code ) { return {}; }
+    detail::check_assigned(*code);
+    return (*code)(value);
+}
+
+auto compute(std::string && source, char x, const_t const & value)
+    -> std::optional<const_t>
+{
+    return compute(static_cast<std::string const &>(source), x, value);
+}
+
+auto parse_function(std::string const & source, char x, expression::policy p)
+    -> std::optional<std::function<const_t(const_t)>>
+{
+    auto code = program_cache::global().get(source, p, x);
+    if ( ! code ) { return {}; }
+    detail::check_assigned(*code);
+    return [code=std::move(code)](const_t const & value) noexcept { return (*code)(value); };
+}
+
+auto parse_function(std::string && source, char x, expression::policy p)
+    -> std::optional<std::function<const_t(const_t)>>
+{
+    return parse_function(static_cast<std::string const &>(source), x, p);
+}
+
+} // namespace expr
@@ -0,0 +1,100 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : program_cache
+ * @created     : Friday October 16, 2026 16:21:05 CEST
+ * @license     : MIT
+ * */
+
+#ifndef PROGRAM_CACHE_HPP
+#define PROGRAM_CACHE_HPP
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <string_view>
+#include <unordered_map>
+#include "expression.hpp"
+#include "program.hpp"
+
+namespace expr
+{
+
+// Compiled programs by (source, policy, variable), shared by every caller.
+// The keys are spread over independent shards, each one a LRU list under its
+// own lock: threads asking for different sources rarely wait for each other.
+// A hit neither parses nor allocates
+class program_cache
+{
+public:
+    struct statistics
+    {
+        std::size_t hits      = 0;
+        std::size_t misses    = 0;
+        std::size_t evictions = 0;
+        std::size_t size      = 0;
+    };
+
+    static constexpr std::size_t default_capacity = 4096;
+    static constexpr std::size_t default_shards   = 16;
+
+    explicit program_cache(std::size_t capacity = default_capacity, std::size_t shards = default_shards);
+    program_cache(program_cache const &) = delete;
+    program_cache & operator=(program_cache const &) = delete;
+
+    // The program of `source` with `x` as variable, compiled on a miss; nullptr
+    // for an empty expression. Parsing errors are thrown and nothing is stored
+    std::shared_ptr<program const> get(std::string_view source, expression::policy p, char x);
+
+    statistics stats() const;
+    void clear();
+
+    // The one used by compute() and parse_function()
+    static program_cache & global();
+
+private:
+    struct entry
+    {
+        std::string source;
+        expression::policy policy;
+        char variable;
+        std::shared_ptr<program const> code;
+    };
+
+    // Views the source owned by the entry in the list, so looking up needs no copy
+    struct key
+    {
+        std::string_view source;
+        expression::policy policy;
+        char variable;
+
+        bool operator==(key const & other) const noexcept
+        {
+            return variable == other.variable && policy == other.policy && source == other.source;
+        }
+    };
+
+    struct hasher
+    {
+        std::size_t operator()(key const & k) const noexcept;
+    };
+
+    struct shard
+    {
+        mutable std::mutex mutex;
+        std::list<entry> order;                 // most recently used first
+        std::unordered_map<key, std::list<entry>::iterator, hasher> index;
+        std::size_t hits      = 0;
+        std::size_t misses    = 0;
+        std::size_t evictions = 0;
+    };
+
+    std::vector<std::unique_ptr<shard>> _shards;
+    std::size_t _capacity;                      // per shard
+};
+
+} // namespace expr
+
+#endif /* PROGRAM_CACHE_HPP */
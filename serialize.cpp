@@ -0,0 +1,333 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : serialize
+ * @created     : Friday October 16, 2026 17:58:03 CEST
+ * @license     : MIT
+ * */
+
+#include <cstring>
+#include <utility>
+#include <stdexcept>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "serialize.hpp"
+
+
+namespace expr
+{
+
+namespace detail
+{
+    constexpr char format_magic[8] = {'e', 'x', 'p', 'r', 'p', 'r', 'o', 'g'};
+    constexpr std::size_t file_header   = 32;
+    constexpr std::size_t record_header = 24;
+    constexpr std::size_t encoded_instruction = 16;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    constexpr bool little_endian = true;
+#else
+    constexpr bool little_endian = false;
+#endif
+
+    // In place, the encoded instructions are read as they are
+    static_assert(sizeof(instruction) == encoded_instruction);
+    static_assert(offsetof(instruction, a) == 4 && offsetof(instruction, b) == 8 && offsetof(instruction, c) == 12);
+
+    constexpr std::uint64_t padded(std::uint64_t n) noexcept { return (n + 7) / 8 * 8; }
+
+    template <typename T>
+    void put(std::vector<std::byte> & out, T value)
+    {
+        for ( std::size_t i = 0; i < sizeof(T); ++i ) {
+            out.push_back(static_cast<std::byte>(value >> (8 * i)));
+        }
+    }
+
+    void put(std::vector<std::byte> & out, const_t value)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        put(out, bits);
+    }
+
+    template <typename T>
+    void patch(std::vector<std::byte> & out, std::size_t at, T value)
+    {
+        for ( std::size_t i = 0; i < sizeof(T); ++i ) {
+            out[at + i] = static_cast<std::byte>(value >> (8 * i));
+        }
+    }
+
+    template <typename T>
+    T get(std::byte const * in) noexcept
+    {
+        T value = 0;
+        for ( std::size_t i = 0; i < sizeof(T); ++i ) {
+            value |= static_cast<T>(std::to_integer<std::uint8_t>(in[i])) << (8 * i);
+        }
+        return value;
+    }
+
+    template <>
+    const_t get<const_t>(std::byte const * in) noexcept
+    {
+        auto const bits = get<std::uint64_t>(in);
+        const_t value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // Where the arrays of a program are, as offsets from the start of the bytes
+    struct record
+    {
+        std::uint32_t size, constants, variables, parameters;
+        std::uint8_t precision;
+        std::uint64_t at;
+
+        std::uint64_t pool()       const noexcept { return at + record_header; }
+        std::uint64_t bindings()   const noexcept { return this->pool() + std::uint64_t{constants} * sizeof(const_t); }
+        std::uint64_t code()       const noexcept { return this->bindings() + std::uint64_t{parameters} * sizeof(const_t); }
+        std::uint64_t names()      const noexcept { return this->code() + std::uint64_t{size} * encoded_instruction; }
+        std::uint64_t parameter_names() const noexcept { return this->names() + variables; }
+        std::uint64_t end()        const noexcept { return this->parameter_names() + parameters; }
+    };
+
+    void write(std::vector<std::byte> & out, program const & p)
+    {
+        put(out, static_cast<std::uint32_t>(p.code().size()));
+        put(out, static_cast<std::uint32_t>(p.constants().size()));
+        put(out, static_cast<std::uint32_t>(p.variables().size()));
+        put(out, static_cast<std::uint32_t>(p.parameters().size()));
+        put(out, static_cast<std::uint8_t>(p.precision()));
+        out.resize(out.size() + 7);
+        for ( auto value : p.constants() ) { put(out, value); }
+        for ( auto value : p.bindings()  ) { put(out, value); }
+        for ( auto const & ins : p.code() ) {
+            put(out, static_cast<std::uint8_t>(ins.op));
+            out.resize(out.size() + 3);
+            put(out, ins.a);
+            put(out, ins.b);
+            put(out, ins.c);
+        }
+        for ( auto name : p.variables()  ) { put(out, static_cast<std::uint8_t>(name)); }
+        for ( auto name : p.parameters() ) { put(out, static_cast<std::uint8_t>(name)); }
+        out.resize(padded(out.size()));
+    }
+
+    // The number of programs, after checking the header and the offset table
+    std::uint64_t count(span<std::byte const> bytes)
+    {
+        if ( bytes.size() < file_header || std::memcmp(bytes.data(), format_magic, sizeof(format_magic)) != 0 ) {
+            throw std::invalid_argument{"Not a serialized program"};
+        }
+        if ( get<std::uint32_t>(bytes.data() + 8) != format_version ) {
+            throw std::invalid_argument{"Unsupported format version"};
+        }
+        if ( get<std::uint32_t>(bytes.data() + 12) != compiler_version ) {
+            throw std::invalid_argument{"Compiled by another version"};
+        }
+        auto const n = get<std::uint64_t>(bytes.data() + 16);
+        if ( get<std::uint64_t>(bytes.data() + 24) != bytes.size() || n > (bytes.size() - file_header) / 8 ) {
+            throw std::invalid_argument{"Truncated serialized program"};
+        }
+        return n;
+    }
+
+    record locate(span<std::byte const> bytes, std::size_t index)
+    {
+        auto const at = get<std::uint64_t>(bytes.data() + file_header + 8 * index);
+        if ( at % 8 != 0 || at > bytes.size() || bytes.size() - at < record_header ) {
+            throw std::invalid_argument{"Invalid offset of program " + std::to_string(index)};
+        }
+        auto const * h = bytes.data() + at;
+        record r{
+            get<std::uint32_t>(h), get<std::uint32_t>(h + 4), get<std::uint32_t>(h + 8),
+            get<std::uint32_t>(h + 12), get<std::uint8_t>(h + 16), at
+        };
+        if ( r.end() > bytes.size() || r.precision > static_cast<std::uint8_t>(accuracy::coarse) ) {
+            throw std::invalid_argument{"Invalid program " + std::to_string(index)};
+        }
+        return r;
+    }
+
+    program_view view(std::byte const * data, record const & r) noexcept
+    {
+        auto const image = expr::image{
+            reinterpret_cast<instruction const *>(data + r.code()), r.size,
+            reinterpret_cast<const_t const *>(data + r.pool()),
+            reinterpret_cast<const_t const *>(data + r.bindings()),
+            static_cast<accuracy>(r.precision)
+        };
+        return program_view{
+            image,
+            { reinterpret_cast<char const *>(data + r.names()), r.variables },
+            { reinterpret_cast<char const *>(data + r.parameter_names()), r.parameters }
+        };
+    }
+} // namespace detail
+
+std::vector<std::byte> serialize(program const & p)
+{
+    return serialize(span<program const>{&p, 1});
+}
+
+std::vector<std::byte> serialize(span<program const> programs)
+{
+    std::vector<std::byte> out(
+        reinterpret_cast<std::byte const *>(detail::format_magic),
+        reinterpret_cast<std::byte const *>(detail::format_magic) + sizeof(detail::format_magic)
+    );
+    out.reserve(detail::file_header + 8 * programs.size());
+    detail::put(out, format_version);
+    detail::put(out, compiler_version);
+    detail::put(out, static_cast<std::uint64_t>(programs.size()));
+    detail::put(out, std::uint64_t{0});
+    out.resize(out.size() + 8 * programs.size());
+
+    for ( std::size_t i = 0; i < programs.size(); ++i ) {
+        detail::patch(out, detail::file_header + 8 * i, static_cast<std::uint64_t>(out.size()));
+        detail::write(out, programs[i]);
+    }
+    detail::patch(out, 24, static_cast<std::uint64_t>(out.size()));
+    return out;
+}
+
+program deserialize(span<std::byte const> bytes, std::size_t index)
+{
+    if ( index >= detail::count(bytes) ) {
+        throw std::invalid_argument{"No program " + std::to_string(index)};
+    }
+    auto const r = detail::locate(bytes, index);
+    auto const * data = bytes.data();
+
+    std::vector<const_t> constants(r.constants), bindings(r.parameters);
+    for ( std::size_t i = 0; i < constants.size(); ++i ) {
+        constants[i] = detail::get<const_t>(data + r.pool() + i * sizeof(const_t));
+    }
+    for ( std::size_t i = 0; i < bindings.size(); ++i ) {
+        bindings[i] = detail::get<const_t>(data + r.bindings() + i * sizeof(const_t));
+    }
+    std::vector<instruction> code(r.size);
+    for ( std::size_t i = 0; i < code.size(); ++i ) {
+        auto const * in = data + r.code() + i * detail::encoded_instruction;
+        code[i] = {
+            static_cast<opcode>(detail::get<std::uint8_t>(in)),
+            detail::get<std::uint32_t>(in + 4), detail::get<std::uint32_t>(in + 8), detail::get<std::uint32_t>(in + 12)
+        };
+    }
+    auto const * names = reinterpret_cast<char const *>(data + r.names());
+    std::vector<char> variables(names, names + r.variables);
+    std::vector<char> parameters(names + r.variables, names + r.variables + r.parameters);
+
+    return program{
+        std::move(code), std::move(constants), std::move(variables),
+        std::move(parameters), std::move(bindings), static_cast<accuracy>(r.precision)
+    };
+}
+
+const_t program_view::operator()(const_t const & x) const noexcept
+{
+    return execute(_image, x, nullptr, 0);
+}
+
+const_t program_view::operator()(const_t const & x, span<const_t const> params) const noexcept
+{
+    return execute(_image, x, params.data(), params.size());
+}
+
+void program_view::operator()(span<const_t const> in, span<const_t> out) const noexcept
+{
+    execute(_image, in.data(), out.data(), std::min(in.size(), out.size()), nullptr, 0);
+}
+
+void program_view::operator()(span<const_t const> in, span<const_t> out, span<const_t const> params) const noexcept
+{
+    execute(_image, in.data(), out.data(), std::min(in.size(), out.size()), params.data(), params.size());
+}
+
+library::library(span<std::byte const> bytes)
+{
+    if constexpr ( ! detail::little_endian ) {
+        throw std::runtime_error{"Programs can be used in place only on a little-endian machine"};
+    }
+    if ( reinterpret_cast<std::uintptr_t>(bytes.data()) % 8 != 0 ) {
+        throw std::runtime_error{"Programs can be used in place only from memory aligned to 8"};
+    }
+    auto const n = detail::count(bytes);
+    for ( std::size_t i = 0; i < n; ++i ) {
+        auto const r = detail::locate(bytes, i);
+        auto const v = detail::view(bytes.data(), r);
+        if ( ! verify(v.view().code, r.size, r.constants, r.variables, r.parameters) ) {
+            throw std::invalid_argument{"Invalid program " + std::to_string(i)};
+        }
+    }
+    _data  = bytes.data();
+    _count = n;
+}
+
+program_view library::operator[](std::size_t index) const noexcept
+{
+    auto const * h = _data + detail::get<std::uint64_t>(_data + detail::file_header + 8 * index);
+    auto const r = detail::record{
+        detail::get<std::uint32_t>(h), detail::get<std::uint32_t>(h + 4), detail::get<std::uint32_t>(h + 8),
+        detail::get<std::uint32_t>(h + 12), detail::get<std::uint8_t>(h + 16), static_cast<std::uint64_t>(h - _data)
+    };
+    return detail::view(_data, r);
+}
+
+program_view library::at(std::size_t index) const
+{
+    if ( index >= _count ) {
+        throw std::out_of_range{"No program " + std::to_string(index)};
+    }
+    return (*this)[index];
+}
+
+mapped_file::mapped_file(std::string const & path) noexcept
+{
+    auto const fd = ::open(path.c_str(), O_RDONLY);
+    if ( fd < 0 ) {
+        return;
+    }
+    struct stat info;
+    if ( ::fstat(fd, &info) == 0 && info.st_size > 0 ) {
+        auto * data = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if ( data != MAP_FAILED ) {
+            _data = data;
+            _size = static_cast<std::size_t>(info.st_size);
+        }
+    }
+    ::close(fd);
+}
+
+mapped_file::~mapped_file()
+{
+    if ( _data ) {
+        ::munmap(_data, _size);
+    }
+}
+
+mapped_file::mapped_file(mapped_file && other) noexcept :
+    _data{ std::exchange(other._data, nullptr) }, _size{ std::exchange(other._size, 0) }
+{ ; }
+
+mapped_file & mapped_file::operator=(mapped_file other) noexcept
+{
+    std::swap(_data, other._data);
+    std::swap(_size, other._size);
+    return *this;
+}
+
+mapped_library::mapped_library(std::string const & path) :
+    _file{path}
+{
+    if ( _file.empty() ) {
+        throw std::runtime_error{"Cannot map " + path};
+    }
+    _library = library{_file.bytes()};
+}
+
+} // namespace expr
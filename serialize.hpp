@@ -0,0 +1,116 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : serialize
+ * @created     : Friday October 16, 2026 17:41:36 CEST
+ * @license     : MIT
+ * */
+
+#ifndef SERIALIZE_HPP
+#define SERIALIZE_HPP
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "expression.hpp"
+#include "program.hpp"
+
+namespace expr
+{
+
+// Binary form of one or more compiled programs. Everything is little-endian and
+// every position is an offset from the first byte, so a file can be mapped
+// anywhere and its programs evaluated where they are:
+//
+//   header   magic "exprprog", u32 format version, u32 compiler version,
+//            u64 number of programs, u64 total size
+//   offsets  u64 for each program, multiple of 8
+//   program  u32 instructions, u32 constants, u32 variables, u32 parameters,
+//            u8 accuracy, 7 bytes reserved;
+//            f64 constant pool, f64 bound values of the parameters,
+//            instructions of 16 bytes (u8 opcode, 3 bytes reserved, u32 a, b, c),
+//            names of the variables, names of the parameters, padding to 8
+inline constexpr std::uint32_t format_version = 1;
+
+std::vector<std::byte> serialize(program const & p);
+std::vector<std::byte> serialize(span<program const> programs);
+
+// A copy of the program at `index`; needs neither alignment nor a little-endian
+// machine. Throws std::invalid_argument if the bytes are not a valid file
+program deserialize(span<std::byte const> bytes, std::size_t index = 0);
+
+// One program of a library: it evaluates the serialized code in place
+class program_view
+{
+    image _image;
+    span<char const> _variables;
+    span<char const> _parameters;
+
+public:
+    program_view(image code, span<char const> variables, span<char const> parameters) noexcept :
+        _image{code}, _variables{variables}, _parameters{parameters}
+    { ; }
+
+    const_t operator()(const_t const & x) const noexcept;
+    const_t operator()(const_t const & x, span<const_t const> params) const noexcept;
+    void operator()(span<const_t const> in, span<const_t> out) const noexcept;
+    void operator()(span<const_t const> in, span<const_t> out, span<const_t const> params) const noexcept;
+
+    span<char const> variables()  const noexcept { return _variables; }
+    span<char const> parameters() const noexcept { return _parameters; }
+    image const & view() const noexcept { return _image; }
+};
+
+// The programs of serialized bytes which stay owned by someone else. Every
+// program is checked once here, so evaluating needs no further check. Throws
+// std::invalid_argument for invalid bytes, std::runtime_error on a big-endian
+// machine or if the bytes are not aligned to 8 (use deserialize() there)
+class library
+{
+    std::byte const * _data = nullptr;
+    std::size_t _count = 0;
+
+public:
+    library() noexcept = default;
+    explicit library(span<std::byte const> bytes);
+
+    std::size_t size() const noexcept { return _count; }
+    program_view operator[](std::size_t index) const noexcept;
+    program_view at(std::size_t index) const;
+};
+
+// A read-only mapping of a whole file; empty if it cannot be opened
+class mapped_file
+{
+    void * _data = nullptr;
+    std::size_t _size = 0;
+
+public:
+    explicit mapped_file(std::string const & path) noexcept;
+    ~mapped_file();
+    mapped_file(mapped_file && other) noexcept;
+    mapped_file & operator=(mapped_file other) noexcept;
+
+    span<std::byte const> bytes() const noexcept { return { static_cast<std::byte const *>(_data), _size }; }
+    bool empty() const noexcept { return _size == 0; }
+};
+
+// A library in a file, mapped instead of read: opening it costs the check of
+// the programs, not a copy of them
+class mapped_library
+{
+    mapped_file _file;
+    library _library;
+
+public:
+    // Throws std::runtime_error if the file cannot be mapped, and as library
+    explicit mapped_library(std::string const & path);
+
+    std::size_t size() const noexcept { return _library.size(); }
+    program_view operator[](std::size_t index) const noexcept { return _library[index]; }
+    program_view at(std::size_t index) const { return _library.at(index); }
+};
+
+} // namespace expr
+
+#endif /* SERIALIZE_HPP */
@@ -0,0 +1,215 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : statistics
+ * @created     : Friday October 16, 2026 20:49:03 CEST
+ * @license     : MIT
+ * */
+
+#include <cmath>
+#include <sstream>
+#include <algorithm>
+#include "statistics.hpp"
+
+
+namespace expr
+{
+
+namespace detail
+{
+    // Threads get their stripe round robin, the first time they record
+    std::size_t own_stripe() noexcept
+    {
+        static std::atomic<std::size_t> next{0};
+        thread_local std::size_t const mine = next.fetch_add(1, std::memory_order_relaxed) % expression_stats::stripes;
+        return mine;
+    }
+
+    std::size_t magnitude(std::uint64_t v) noexcept
+    {
+        std::size_t k = 0;
+        while ( v >>= 1 ) { ++k; }
+        return k;
+    }
+
+    std::string escape_label(std::string const & text)
+    {
+        std::string result;
+        for ( auto c : text ) {
+            if      ( c == '\\' ) { result += "\\\\"; }
+            else if ( c == '"' )  { result += "\\\""; }
+            else if ( c == '\n' ) { result += "\\n"; }
+            else                  { result += c; }
+        }
+        return result;
+    }
+} // namespace detail
+
+std::size_t latency_buckets::index(std::uint64_t ns) noexcept
+{
+    if ( ns < sub_buckets ) {
+        return static_cast<std::size_t>(ns);
+    }
+    ns = std::min(ns, (std::uint64_t{1} << magnitudes) - 1);
+    auto const k = detail::magnitude(ns);
+    auto const sub = static_cast<std::size_t>(ns >> (k - 3)) & (sub_buckets - 1);
+    return (k - 2) * sub_buckets + sub;
+}
+
+std::uint64_t latency_buckets::lower(std::size_t i) noexcept
+{
+    if ( i < sub_buckets ) {
+        return i;
+    }
+    auto const k = i / sub_buckets + 2;
+    return (sub_buckets + i % sub_buckets) << (k - 3);
+}
+
+std::uint64_t latency_buckets::upper(std::size_t i) noexcept
+{
+    return i + 1 < count ? lower(i + 1) : std::uint64_t{1} << magnitudes;
+}
+
+double stats_snapshot::mean_ns() const noexcept
+{
+    return calls == 0 ? 0.0 : static_cast<double>(total_ns) / static_cast<double>(calls);
+}
+
+std::uint64_t stats_snapshot::quantile_ns(double q) const noexcept
+{
+    std::uint64_t recorded = 0;
+    for ( auto n : latency ) { recorded += n; }
+    if ( recorded == 0 ) {
+        return 0;
+    }
+    auto const wanted = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * recorded)));
+    std::uint64_t seen = 0;
+    for ( std::size_t i = 0; i < latency.size(); ++i ) {
+        seen += latency[i];
+        if ( seen >= wanted ) {
+            return latency_buckets::upper(i);
+        }
+    }
+    return latency_buckets::upper(latency.size() - 1);
+}
+
+expression_stats::expression_stats(std::string name) :
+    _name{ std::move(name) }, _stripes{ std::make_unique<stripe[]>(stripes) }
+{ ; }
+
+void expression_stats::record(std::uint64_t ns, std::size_t elements, bool batch) noexcept
+{
+    auto & s = _stripes[detail::own_stripe()];
+    constexpr auto relaxed = std::memory_order_relaxed;
+    s.calls.fetch_add(1, relaxed);
+    s.elements.fetch_add(elements, relaxed);
+    if ( batch ) {
+        s.batches.fetch_add(1, relaxed);
+        s.batched.fetch_add(elements, relaxed);
+    }
+    s.total_ns.fetch_add(ns, relaxed);
+    s.latency[latency_buckets::index(ns)].fetch_add(1, relaxed);
+}
+
+stats_snapshot expression_stats::snapshot() const
+{
+    stats_snapshot result;
+    result.name = _name;
+    for ( std::size_t i = 0; i < stripes; ++i ) {
+        auto const & s = _stripes[i];
+        result.calls    += s.calls.load(std::memory_order_relaxed);
+        result.batches  += s.batches.load(std::memory_order_relaxed);
+        result.elements += s.elements.load(std::memory_order_relaxed);
+        result.batched  += s.batched.load(std::memory_order_relaxed);
+        result.total_ns += s.total_ns.load(std::memory_order_relaxed);
+        for ( std::size_t b = 0; b < latency_buckets::count; ++b ) {
+            result.latency[b] += s.latency[b].load(std::memory_order_relaxed);
+        }
+    }
+    return result;
+}
+
+void expression_stats::reset() noexcept
+{
+    for ( std::size_t i = 0; i < stripes; ++i ) {
+        auto & s = _stripes[i];
+        s.calls.store(0);
+        s.batches.store(0);
+        s.elements.store(0);
+        s.batched.store(0);
+        s.total_ns.store(0);
+        for ( auto & b : s.latency ) { b.store(0); }
+    }
+}
+
+std::shared_ptr<expression_stats> stats_registry::add(std::string name)
+{
+    auto stats = std::make_shared<expression_stats>(std::move(name));
+    std::lock_guard lock{_mutex};
+    _entries.push_back(stats);
+    return stats;
+}
+
+// Entries of expressions which are gone are dropped here
+std::vector<stats_snapshot> stats_registry::snapshot() const
+{
+    std::vector<stats_snapshot> result;
+    std::lock_guard lock{_mutex};
+    auto const gone = std::remove_if(_entries.begin(), _entries.end(), [&](auto const & entry) {
+        auto const stats = entry.lock();
+        if ( ! stats ) { return true; }
+        result.push_back(stats->snapshot());
+        return false;
+    });
+    _entries.erase(gone, _entries.end());
+    return result;
+}
+
+stats_registry & stats_registry::global()
+{
+    static stats_registry registry;
+    return registry;
+}
+
+std::string to_prometheus(std::vector<stats_snapshot> const & snapshots)
+{
+    static constexpr std::uint64_t bounds[] = {
+        100, 250, 500, 1'000, 2'500, 5'000, 10'000, 25'000, 50'000, 100'000, 250'000, 500'000,
+        1'000'000, 10'000'000, 100'000'000, 1'000'000'000, 10'000'000'000,
+    };
+
+    std::ostringstream out;
+    auto const counter = [&](char const * metric, char const * help, auto field) {
+        out << "# HELP " << metric << ' ' << help << '\n';
+        out << "# TYPE " << metric << " counter\n";
+        for ( auto const & s : snapshots ) {
+            out << metric << "{expression=\"" << detail::escape_label(s.name) << "\"} " << s.*field << '\n';
+        }
+    };
+    counter("expr_calls_total", "Evaluations, a batch counting once.", &stats_snapshot::calls);
+    counter("expr_elements_total", "Values computed.", &stats_snapshot::elements);
+    counter("expr_batched_elements_total", "Values computed by batch evaluations.", &stats_snapshot::batched);
+
+    out << "# HELP expr_latency_seconds Time of one evaluation, or of one batch.\n";
+    out << "# TYPE expr_latency_seconds histogram\n";
+    for ( auto const & s : snapshots ) {
+        auto const label = "expression=\"" + detail::escape_label(s.name) + "\"";
+        std::size_t b = 0;
+        std::uint64_t below = 0;
+        for ( auto bound : bounds ) {
+            for ( ; b < s.latency.size() && latency_buckets::upper(b) <= bound; ++b ) {
+                below += s.latency[b];
+            }
+            out << "expr_latency_seconds_bucket{" << label << ",le=\"" << static_cast<double>(bound) * 1e-9 << "\"} " << below << '\n';
+        }
+        // Not s.calls, which can be ahead of the histogram while the snapshot is taken
+        for ( ; b < s.latency.size(); ++b ) {
+            below += s.latency[b];
+        }
+        out << "expr_latency_seconds_bucket{" << label << ",le=\"+Inf\"} " << below << '\n';
+        out << "expr_latency_seconds_sum{" << label << "} " << static_cast<double>(s.total_ns) * 1e-9 << '\n';
+        out << "expr_latency_seconds_count{" << label << "} " << below << '\n';
+    }
+    return out.str();
+}
+
+} // namespace expr
@@ -0,0 +1,135 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : statistics
+ * @created     : Friday October 16, 2026 20:41:17 CEST
+ * @license     : MIT
+ * */
+
+#ifndef STATISTICS_HPP
+#define STATISTICS_HPP
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace expr
+{
+
+// Latencies in nanoseconds, HDR-like: exact below 8 ns, then every power of two
+// is split in 8 buckets (at most 12.5% wide) up to 2^36 ns, about 69 seconds;
+// slower calls go to the last bucket
+struct latency_buckets
+{
+    static constexpr std::size_t sub_buckets = 8;
+    static constexpr std::size_t magnitudes  = 36;
+    static constexpr std::size_t count = (magnitudes - 2) * sub_buckets;
+
+    static std::size_t index(std::uint64_t ns) noexcept;
+    static std::uint64_t lower(std::size_t i) noexcept;
+    static std::uint64_t upper(std::size_t i) noexcept;    // exclusive
+};
+
+// A copy of the counters of one expression, consistent enough for monitoring:
+// calls made while it was taken may be counted in some fields and not in others
+struct stats_snapshot
+{
+    std::string name;
+    std::uint64_t calls    = 0;     // a batch counts once
+    std::uint64_t batches  = 0;     // calls over an array
+    std::uint64_t elements = 0;     // values computed, one per scalar call
+    std::uint64_t batched  = 0;     // values computed by the batches
+    std::uint64_t total_ns = 0;
+    std::array<std::uint64_t, latency_buckets::count> latency{};
+
+    double mean_ns() const noexcept;
+    // Upper bound of the bucket holding the `q`-quantile (0 <= q <= 1), 0 if there were no calls
+    std::uint64_t quantile_ns(double q) const noexcept;
+};
+
+// The counters of one instrumented expression. Each thread adds to one of a few
+// stripes, on its own cache lines, so threads calling the same expression do
+// not fight over the counters; a snapshot adds the stripes up
+class expression_stats
+{
+public:
+    static constexpr std::size_t stripes = 8;
+
+    explicit expression_stats(std::string name);
+    expression_stats(expression_stats const &) = delete;
+    expression_stats & operator=(expression_stats const &) = delete;
+
+    void record(std::uint64_t ns, std::size_t elements, bool batch) noexcept;
+    stats_snapshot snapshot() const;
+    void reset() noexcept;
+    std::string const & name() const noexcept { return _name; }
+
+private:
+    struct alignas(64) stripe
+    {
+        std::atomic<std::uint64_t> calls{0};
+        std::atomic<std::uint64_t> batches{0};
+        std::atomic<std::uint64_t> elements{0};
+        std::atomic<std::uint64_t> batched{0};
+        std::atomic<std::uint64_t> total_ns{0};
+        std::array<std::atomic<std::uint64_t>, latency_buckets::count> latency{};
+    };
+
+    std::string _name;
+    std::unique_ptr<stripe[]> _stripes;
+};
+
+// Times a call from its construction to its destruction; does nothing for nullptr
+class stats_scope
+{
+    using clock = std::chrono::steady_clock;
+
+    expression_stats * _stats;
+    std::size_t _elements;
+    bool _batch;
+    clock::time_point _start;
+public:
+    stats_scope(expression_stats * stats, std::size_t elements, bool batch) noexcept :
+        _stats{stats}, _elements{elements}, _batch{batch}, _start{ stats ? clock::now() : clock::time_point{} }
+    { ; }
+
+    ~stats_scope()
+    {
+        if ( _stats ) {
+            auto const elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - _start);
+            _stats->record(static_cast<std::uint64_t>(elapsed.count()), _elements, _batch);
+        }
+    }
+
+    stats_scope(stats_scope const &) = delete;
+    stats_scope & operator=(stats_scope const &) = delete;
+};
+
+// The instrumented expressions still alive, to be exported together
+class stats_registry
+{
+    mutable std::mutex _mutex;
+    mutable std::vector<std::weak_ptr<expression_stats>> _entries;
+
+public:
+    std::shared_ptr<expression_stats> add(std::string name);
+    std::vector<stats_snapshot> snapshot() const;
+
+    // The one compiled_expression::instrument uses by default
+    static stats_registry & global();
+};
+
+// Prometheus text exposition format: expr_calls_total, expr_elements_total,
+// expr_batched_elements_total and the expr_latency_seconds histogram, labelled
+// with expression="name". The histogram is cut at fixed bounds from 100ns to
+// 10s; a bucket straddling one of them is counted above it
+std::string to_prometheus(std::vector<stats_snapshot> const & snapshots);
+
+} // namespace expr
+
+#endif /* STATISTICS_HPP */
@@ -0,0 +1,72 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : allocations
+ * @created     : Saturday October 17, 2026 01:12:37 CEST
+ * @license     : MIT
+ * */
+
+#include <string>
+#include <vector>
+#include "expression.hpp"
+#include "program.hpp"
+#include "allocation_counter.hpp"
+#include "check.hpp"
+
+using namespace expr;
+
+namespace
+{
+    // Every way of evaluating `p`, which must not allocate in the eval phase
+    void evaluate(program const & p, workspace & w)
+    {
+        std::vector<const_t> in(1000), out(in.size());
+        std::vector<const_t> params(p.parameters().size(), 0.5);
+        for ( std::size_t i = 0; i < in.size(); ++i ) {
+            in[i] = static_cast<const_t>(i) / 100;
+        }
+        allocation_counter::reset();
+        for ( auto x : in ) {
+            static_cast<void>(p(x, params.data(), params.size()));
+            static_cast<void>(p(x, params.data(), params.size(), w));
+        }
+        p(in.data(), out.data(), in.size(), params.data(), params.size());
+        p(in.data(), out.data(), in.size(), params.data(), params.size(), w);
+        CHECK(allocation_counter::of(phase::eval).count == 0);
+    }
+} // namespace
+
+int main()
+{
+    CHECK(allocation_counter::enabled());
+
+    allocation_counter::reset();
+    expression F{"sin(x)*exp(0-y^2)+sqrt(x+2)%3"};
+    CHECK(allocation_counter::of(phase::parse).count > 0);
+    F.set_param('y', 1);
+
+    auto const p = *F.compile('x');
+    workspace w{p.view()};
+    evaluate(p, w);
+
+    allocation_counter::reset();
+    static_cast<void>(F.eval('x', 2));
+    static_cast<void>(F.eval());
+    CHECK(allocation_counter::of(phase::eval).count == 0);
+
+    // Past the stack block the registers are kept by the thread: only the first
+    // call grows them
+    std::string text = "0";
+    for ( int k = 1; k <= 600; ++k ) {
+        text += "+sin(x*" + std::to_string(k) + ")";
+    }
+    auto const big = *expression{text}.compile('x');
+    CHECK(big.code().size() > 1024);
+    workspace none;
+    std::vector<const_t> in(100, 1.), out(in.size());
+    static_cast<void>(big(1., nullptr, 0));
+    big(in.data(), out.data(), in.size(), nullptr, 0);
+    evaluate(big, none);
+    workspace reserved{big.view()};
+    evaluate(big, reserved);
+    return 0;
+}
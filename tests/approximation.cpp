@@ -0,0 +1,43 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : approximation
+ * @created     : Friday October 16, 2026 23:55:40 CEST
+ * @license     : MIT
+ * */
+
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include "expression.hpp"
+#include "approximation.hpp"
+#include "check.hpp"
+
+using namespace expr;
+
+int main()
+{
+    expression F{"sin(cos(x))*exp(x/3)+ln(x+2)"};
+    auto const tolerance = 1e-10;
+    auto const f = *F.approximate('x', 0, 10, tolerance);
+    CHECK(f.error() <= tolerance);
+
+    // The estimate holds off the samples too, for a smooth function
+    double worst = 0;
+    for ( int i = 0; i <= 100000; ++i ) {
+        auto const x = 10. * i / 100000;
+        auto const exact = *F.eval('x', x);
+        worst = std::max(worst, std::abs(f(x) - exact) / std::max(1., std::abs(exact)));
+    }
+    CHECK(worst <= 2 * tolerance);
+    CHECK(std::isnan(f(-1)) && std::isnan(f(11)));
+
+    auto failed = false;
+    try {
+        expression{"1/(x-0.5)"}.approximate('x', 0, 1, 1e-9);
+    }
+    catch (std::domain_error const &) {
+        failed = true;
+    }
+    CHECK(failed);
+    return 0;
+}
@@ -0,0 +1,71 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : batch
+ * @created     : Saturday October 17, 2026 00:37:45 CEST
+ * @license     : MIT
+ * */
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "expression.hpp"
+#include "program.hpp"
+#include "bench/generator.hpp"
+#include "check.hpp"
+
+using namespace expr;
+
+namespace
+{
+    // The same bits, or both NaN whatever their payload
+    bool same(const_t a, const_t b)
+    {
+        return (std::isnan(a) && std::isnan(b)) || std::memcmp(&a, &b, sizeof a) == 0;
+    }
+} // namespace
+
+// The batch kernel, with the hoisting of what does not depend on the variable,
+// gives the same bits as the scalar one: on random expressions with parameters,
+// at every accuracy level, with and without a workspace
+int main()
+{
+    accuracy const levels[] = { accuracy::exact, accuracy::faithful, accuracy::single, accuracy::coarse };
+    std::size_t const sizes[] = { 16, 200 };
+
+    std::vector<const_t> in(300), out(in.size()), reserved(in.size());
+    for ( std::size_t i = 0; i < in.size(); ++i ) {
+        in[i] = -4 + 8. * static_cast<const_t>(i) / static_cast<const_t>(in.size());
+    }
+    std::size_t compared = 0;
+    for ( auto size : sizes ) {
+        bench::generator_options options;
+        options.size = size;
+        options.parameters = 3;
+        options.operators[5] = 1;
+        bench::generator random{size, options};
+        for ( int e = 0; e < (size > 100 ? 100 : 1000); ++e ) {
+            expression F{random()};
+            for ( auto level : levels ) {
+                compile_policy policy;
+                policy.precision = level;
+                auto const p = *F.compile('x', policy);
+                std::vector<const_t> params(p.parameters().size());
+                for ( std::size_t k = 0; k < params.size(); ++k ) {
+                    params[k] = 0.75 + static_cast<const_t>(k);
+                }
+
+                workspace w{p.view()};
+                p(in.data(), out.data(), in.size(), params.data(), params.size());
+                p(in.data(), reserved.data(), in.size(), params.data(), params.size(), w);
+                for ( std::size_t i = 0; i < in.size(); ++i ) {
+                    auto const scalar = p(in[i], params.data(), params.size());
+                    CHECK(same(out[i], scalar));
+                    CHECK(same(reserved[i], scalar));
+                }
+                ++compared;
+            }
+        }
+    }
+    CHECK(compared == 4 * 1100);
+    return 0;
+}
@@ -0,0 +1,23 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : check
+ * @created     : Friday October 16, 2026 23:41:07 CEST
+ * @license     : MIT
+ * */
+
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+#include <cstdio>
+#include <cstdlib>
+
+// Unlike assert, checked in every build type: the tests are built in release
+#define CHECK(condition)                                                                  \
+    do {                                                                                  \
+        if ( ! (condition) ) {                                                            \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1);                                                                 \
+        }                                                                                 \
+    } while ( false )
+
+#endif /* CHECK_HPP */
@@ -0,0 +1,54 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : executor
+ * @created     : Saturday October 17, 2026 00:29:14 CEST
+ * @license     : MIT
+ * */
+
+#include <atomic>
+#include <vector>
+#include <stdexcept>
+#include "executor.hpp"
+#include "check.hpp"
+
+using namespace expr;
+
+int main()
+{
+    executor pool{4};
+
+    // Every task runs once, whatever thread takes it
+    std::vector<std::atomic<int>> runs(10000);
+    pool.run(runs.size(), [&](std::size_t i) { ++runs[i]; });
+    for ( auto const & r : runs ) {
+        CHECK(r.load() == 1);
+    }
+    pool.run(0, [](std::size_t) { });
+
+    // The exception of a task reaches the caller, after the other tasks are done
+    std::atomic<int> done{0};
+    auto caught = false;
+    try {
+        pool.run(1000, [&](std::size_t i) {
+            if ( i == 500 ) {
+                throw std::runtime_error{"task 500"};
+            }
+            ++done;
+        });
+    }
+    catch (std::runtime_error const & e) {
+        caught = std::string{e.what()} == "task 500";
+    }
+    CHECK(caught);
+    CHECK(done.load() == 999);
+
+    // The pool is still usable afterwards, and with a single thread
+    std::atomic<int> sum{0};
+    pool.run(100, [&](std::size_t i) { sum += static_cast<int>(i); });
+    CHECK(sum.load() == 4950);
+    executor single{1};
+    sum = 0;
+    single.run(100, [&](std::size_t i) { sum += static_cast<int>(i); });
+    CHECK(sum.load() == 4950);
+    return 0;
+}
@@ -0,0 +1,47 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : fuse
+ * @created     : Friday October 16, 2026 23:48:22 CEST
+ * @license     : MIT
+ * */
+
+#include <cmath>
+#include "program.hpp"
+#include "check.hpp"
+
+using namespace expr;
+
+int main()
+{
+    // Two sin of the same argument, as share() would have merged them
+    program p;
+    auto const x = p.variable('x');
+    auto const s1 = p.emit(opcode::sin, x);
+    auto const c  = p.emit(opcode::cos, x);
+    auto const s2 = p.emit(opcode::sin, x);
+    p.emit(opcode::add, p.emit(opcode::add, s1, c), s2);
+    p.fuse({});
+
+    std::size_t pairs = 0;
+    for ( auto const & ins : p.code() ) {
+        pairs += ins.op == opcode::sincos;
+    }
+    CHECK(pairs == 1);
+    for ( double v : { -3.0, 0.0, 0.5, 2.0 } ) {
+        CHECK(p(v) == std::sin(v) + std::cos(v) + std::sin(v));
+    }
+
+    // The same through optimize(), with share() left out
+    program q{ p.code(), p.constants(), p.variables(), p.parameters(), p.bindings(), p.precision() };
+    program r;
+    auto const y = r.variable('x');
+    r.emit(opcode::mul, r.emit(opcode::cos, y), r.emit(opcode::add, r.emit(opcode::cos, y), r.emit(opcode::sin, y)));
+    compile_policy policy;
+    policy.passes.disable(pass::share);
+    r.optimize(policy, {});
+    for ( double v : { -1.0, 0.25, 3.0 } ) {
+        CHECK(q(v) == p(v));
+        CHECK(r(v) == std::cos(v) * (std::cos(v) + std::sin(v)));
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : grid
+ * @created     : Saturday October 17, 2026 00:44:02 CEST
+ * @license     : MIT
+ * */
+
+#include <cmath>
+#include <vector>
+#include <stdexcept>
+#include "grid.hpp"
+#include "executor.hpp"
+#include "check.hpp"
+
+using namespace expr;
+
+namespace
+{
+    // f at one point, with the scalar kernel
+    const_t at(compiled_expression const & f, const_t x, const_t y, const_t z)
+    {
+        std::vector<const_t> params(f.code().bindings());
+        if ( f.slot('y') != compiled_expression::npos ) { params[f.slot('y')] = y; }
+        if ( f.slot('z') != compiled_expression::npos ) { params[f.slot('z')] = z; }
+        return f(x, params);
+    }
+
+    template <typename F>
+    bool throws(F f)
+    {
+        try {
+            f();
+        }
+        catch (std::invalid_argument const &) {
+            return true;
+        }
+        return false;
+    }
+} // namespace
+
+int main()
+{
+    executor pool{4};
+    expression F{"sin(x)*exp(0-y^2)+z*x"};
+    F.set_param('y', 0).set_param('z', 0);
+    compiled_expression const f{*F.compile('x')};
+
+    // 2D, row major, over more than one tile in each direction
+    axis const plane[] = { { 'x', -3, 3, 1100 }, { 'y', -1, 2, 37 } };
+    std::vector<const_t> out(1100 * 37);
+    eval_grid(f, plane, out, pool);
+    for ( std::size_t j = 0; j < 37; j += 6 ) {
+        for ( std::size_t i = 0; i < 1100; i += 97 ) {
+            CHECK(out[j * 1100 + i] == at(f, plane[0][i], plane[1][j], 0));
+        }
+    }
+
+    // 3D into a transposed layout, z first and y growing downwards: negative and
+    // non-unit strides
+    axis const space[] = { { 'x', 0, 1, 50 }, { 'y', -1, 1, 9 }, { 'z', 2, 3, 5 } };
+    std::vector<const_t> volume(50 * 9 * 5);
+    grid_output layout{ volume.data() + 8 * 5, { 9 * 5, -5, 1 } };
+    eval_grid(f, space, layout, pool);
+    for ( std::size_t k = 0; k < 5; ++k ) {
+        for ( std::size_t j = 0; j < 9; ++j ) {
+            for ( std::size_t i = 0; i < 50; ++i ) {
+                auto const value = volume[i * 45 + (8 - j) * 5 + k];
+                CHECK(value == at(f, space[0][i], space[1][j], space[2][k]));
+            }
+        }
+    }
+
+    // A letter f does not use is only repeated, the expression overload compiles
+    axis const unused[] = { { 'x', 0, 1, 4 }, { 'w', 0, 1, 3 } };
+    std::vector<const_t> small(12);
+    eval_grid(F, unused, small, pool);
+    CHECK(small[0] == small[4] && small[3] == small[11]);
+
+    // What cannot be a grid
+    axis const swapped[] = { { 'y', 0, 1, 4 }, { 'x', 0, 1, 3 } };
+    axis const other[]   = { { 't', 0, 1, 4 } };
+    CHECK(throws([&] { eval_grid(f, swapped, small, pool); }));
+    CHECK(throws([&] { eval_grid(f, other, span<const_t>{ small.data(), 4 }, pool); }));
+    CHECK(throws([&] { eval_grid(f, plane, small, pool); }));
+    CHECK(throws([&] { eval_grid(f, span<axis const>{}, small, pool); }));
+    return 0;
+}
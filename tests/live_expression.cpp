@@ -0,0 +1,85 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : live_expression
+ * @created     : Saturday October 17, 2026 00:21:50 CEST
+ * @license     : MIT
+ * */
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include "live_expression.hpp"
+#include "check.hpp"
+
+using namespace expr;
+
+int main()
+{
+    expression F{"a*x^2"};
+    F.set_param('a', 0);
+    live_expression live{F};
+
+    // Readers never see anything but a published value: a * 2.25 for an integer a,
+    // or the 7 of the build in the middle
+    std::atomic<bool> stop{false};
+    std::atomic<bool> wrong{false};
+    std::vector<std::thread> readers;
+    for ( int t = 0; t < 8; ++t ) {
+        readers.emplace_back([&] {
+            double in[64], out[64];
+            for ( auto & v : in ) { v = 1.5; }
+            while ( ! stop.load() ) {
+                auto const y = live(1.5);
+                auto const a = y / 2.25;
+                wrong = wrong || (y != 7 && a != static_cast<long>(a));
+                live({ in, 64 }, { out, 64 });
+                wrong = wrong || out[0] != out[63];
+            }
+        });
+    }
+
+    // The versions are freed as soon as their last reader leaves: each program is
+    // published only through a handle this test lets go of, so a version freed
+    // is a program expired
+    std::vector<std::weak_ptr<program const>> published;
+    for ( int i = 1; i <= 500; ++i ) {
+        if ( i == 250 ) {
+            live.build("7+0*x");
+            live.build("a*x^2");
+        }
+        auto code = *F.set_param('a', i).compile('x');
+        compiled_expression handle{std::move(code)};
+        published.push_back(handle.share());
+        live.publish(std::move(handle));
+    }
+    stop = true;
+    for ( auto & t : readers ) {
+        t.join();
+    }
+    CHECK(! wrong);
+
+    // No writer ran after the last publication: the readers freed what was left
+    std::size_t expired = 0;
+    for ( auto const & p : published ) {
+        expired += p.expired();
+    }
+    CHECK(expired == published.size() - 1);
+    CHECK(live.retired() == 0);
+    CHECK(live(2) == 500 * 4);
+
+    // A build which throws leaves the version and its source in place
+    auto failed = false;
+    try {
+        live.build("3+");
+    }
+    catch (std::logic_error const &) {
+        failed = true;
+    }
+    CHECK(failed);
+    CHECK(live(2) == 500 * 4);
+    live.set_param('a', 2);
+    CHECK(live(2) == 8);
+    return 0;
+}
@@ -0,0 +1,45 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : narrow
+ * @created     : Saturday October 17, 2026 00:04:13 CEST
+ * @license     : MIT
+ * */
+
+#include <cmath>
+#include <string>
+#include <algorithm>
+#include "expression.hpp"
+#include "program.hpp"
+#include "check.hpp"
+
+using namespace expr;
+
+namespace
+{
+    bool has(program const & p, opcode op)
+    {
+        return std::any_of(p.code().begin(), p.code().end(), [&](instruction const & ins) { return ins.op == op; });
+    }
+} // namespace
+
+int main()
+{
+    // Non-negative on [0, 10]: the abs goes, also when it is the result
+    for ( std::string source : { "abs(x*x)+1", "abs(sqrt(x))+1", "abs(x^2)+1", "abs(2*x)+1", "abs(x)", "abs(exp(x))" } ) {
+        expression F{source};
+        F.set_domain('x', 0, 10);
+        auto const p = *F.compile('x');
+        CHECK(! has(p, opcode::abs));
+        for ( double x : { 0.0, 0.5, 3.0, 10.0 } ) {
+            CHECK(p(x) == *F.eval('x', x));
+        }
+    }
+
+    // Not on [-1, 10]
+    expression G{"abs(x*3)+1"};
+    G.set_domain('x', -1, 10);
+    auto const q = *G.compile('x');
+    CHECK(has(q, opcode::abs));
+    CHECK(q(-1) == 4);
+    return 0;
+}
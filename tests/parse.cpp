@@ -0,0 +1,32 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : parse
+ * @created     : Saturday October 17, 2026 00:12:36 CEST
+ * @license     : MIT
+ * */
+
+#include <cmath>
+#include <utility>
+#include "expression.hpp"
+#include "check.hpp"
+
+using namespace expr;
+
+int main()
+{
+    // abs binds as tightly as the other functions
+    CHECK(*expression{"abs(x)+1"}.eval('x', -3) == 4);
+    CHECK(*expression{"1+abs(x)*2"}.eval('x', -3) == 7);
+    CHECK(*expression{"abs(x-5)^2"}.eval('x', 1) == 16);
+    CHECK(*expression{"sin(x)+1"}.eval('x', 0) == 1);
+
+    // eval() never throws: a missing value is a NaN, and only an expression
+    // without a tree has no result
+    static_assert(noexcept(std::declval<expression const &>().eval()));
+    static_assert(noexcept(std::declval<expression const &>().eval('x', 1.)));
+    expression F{"x+y"};
+    CHECK(std::isnan(*F.eval('x', 1)));
+    expression G{std::move(F)};
+    CHECK(! F.eval() && G.eval());
+    return 0;
+}
@@ -0,0 +1,53 @@
+/**
+ * @author      : Riccardo Brugo (brugo.riccardo@gmail.com)
+ * @file        : saturate
+ * @created     : Saturday October 17, 2026 01:31:50 CEST
+ * @license     : MIT
+ * */
+
+#include <cmath>
+#include <limits>
+#include "expression.hpp"
+#include "program.hpp"
+#include "check.hpp"
+
+using namespace expr;
+
+namespace
+{
+    // NaN, infinite or finite, and the sign of the infinities
+    bool same_kind(const_t a, const_t b)
+    {
+        if ( std::isnan(a) || std::isnan(b) ) { return std::isnan(a) && std::isnan(b); }
+        if ( std::isinf(a) || std::isinf(b) ) { return a == b; }
+        return true;
+    }
+} // namespace
+
+int main()
+{
+    compile_policy heavy;
+    heavy.passes.enable(pass::saturate);
+
+    // Forms whose textbook identities change what happens at infinities, at NaN
+    // or on overflow: the saturated program has to keep it
+    char const * const forms[] = {
+        "sin(x)^2+cos(x)^2", "exp(x)*exp(x*2)", "exp(x)/exp(x)", "exp(x)^0",
+        "ln(exp(x))", "sqrt(x*x)", "x*sin(x)+x*cos(x)",
+    };
+    auto const inf = std::numeric_limits<const_t>::infinity();
+    const_t const points[] = { inf, -inf, std::nan(""), 800, -800, 1e200, 0.5 };
+    for ( auto text : forms ) {
+        expression F{text};
+        auto const plain = *F.compile('x');
+        auto const saturated = *F.compile('x', heavy);
+        for ( auto x : points ) {
+            CHECK(same_kind(plain(x), saturated(x)));
+        }
+    }
+
+    // Still a pass that finds cheaper forms
+    expression G{"x*sin(x)+x*cos(x)"};
+    CHECK(G.compile('x', heavy)->code().size() < G.compile('x')->code().size());
+    return 0;
+}